@@ -19,6 +19,10 @@
 #include "Comphi/API/ComphiAPI.h"
 // ---
 
+//Benchmarks
+#include "Comphi/Benchmarks/Benchmarks.h"
+// ---
+
 // ------------ Comphi Entry Point ------------
 #include "Comphi/Core/EntryPoint.h"
 // --------------------------------------------
@@ -31,31 +31,25 @@ namespace Comphi {
         auto camera = std::make_shared<Vulkan::Camera>();
         auto icamera = std::static_pointer_cast<ICamera>(camera);
         auto camobj = std::make_shared<Comphi::Camera>(icamera);
-        camobj->bufferViewProjectionMatrix = CreateObject::BufferData(nullptr, sizeof(glm::mat4), 1, UniformBuffer);
         pool->Add(camera.get());
         return camobj;
     }
 
-    TransformPtr ComphiAPI::CreateComponent::Transform(IObjectPool* pool)
+    TransformPtr ComphiAPI::CreateComponent::Transform()
     {
         auto transform = std::make_shared<Comphi::Transform>();
-        transform->bufferModelMatrix = CreateObject::BufferData(nullptr, sizeof(glm::mat4), 1, UniformBuffer);
-        pool->Add(transform.get());
         return transform;
     }
 
-    TransformPtr ComphiAPI::CreateComponent::Transform(TransformPtr& parent, IObjectPool* pool)
+    TransformPtr ComphiAPI::CreateComponent::Transform(TransformPtr& parent)
     {
         auto transform = std::make_shared<Comphi::Transform>(parent);
-        transform->bufferModelMatrix = CreateObject::BufferData(nullptr, sizeof(glm::mat4), 1, UniformBuffer);
-        pool->Add(transform.get());
         return transform;
     }
 
-    RendererPtr ComphiAPI::CreateComponent::Renderer(MeshObjectPtr& meshObject, MaterialInstancePtr& materialInstance, IObjectPool* pool)
+    RendererPtr ComphiAPI::CreateComponent::Renderer(MeshObjectPtr& meshObject, MaterialInstancePtr& materialInstance)
     {
         auto renderer = std::make_shared<Comphi::Renderer>(meshObject, materialInstance);
-        pool->Add(renderer.get());
         return renderer;
     }
 
@@ -211,6 +205,7 @@ namespace Comphi {
     {
         COMPHILOG_CORE_TRACE("Cleaning ComphiAPI Instances...");
         objectPool.cleanUp();
+        Material::releaseSharedPipelines();
         /*cameraPool.cleanUp();
         gameObjectPool .cleanUp();
         shaderPool     .cleanUp();
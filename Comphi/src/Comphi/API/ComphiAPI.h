@@ -48,9 +48,10 @@ namespace Comphi {
 
 		struct CreateComponent {
 			static CameraPtr Camera(IObjectPool* pool = &objectPool);
-			static TransformPtr Transform(IObjectPool* pool = &objectPool);
-			static TransformPtr Transform(TransformPtr& parent, IObjectPool* pool = &objectPool);
-			static RendererPtr Renderer(MeshObjectPtr& meshObject, MaterialInstancePtr& materialInstance, IObjectPool* pool = &objectPool);
+			//Components are owned by the EntityRegistry once added to an Entity
+			static TransformPtr Transform();
+			static TransformPtr Transform(TransformPtr& parent);
+			static RendererPtr Renderer(MeshObjectPtr& meshObject, MaterialInstancePtr& materialInstance);
 			//TODO: new components
 			//Light
 			//Script
@@ -1,7 +1,6 @@
 #pragma once
 #include "Component.h"
 #include "Comphi/Renderer/ICamera.h"
-#include "Comphi/API/Rendering/ShaderBufferData.h"
 
 namespace Comphi {
 
@@ -17,7 +16,6 @@ namespace Comphi {
 			iCameraPtr->properties = properties; //TODO: this is not ideal
 			return iCameraPtr->getProjectionMatrix(); 
 		};
-		BufferDataPtr bufferViewProjectionMatrix;
 	private:
 		ICameraPtr iCameraPtr;
 	};
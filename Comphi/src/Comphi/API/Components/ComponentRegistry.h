@@ -0,0 +1,40 @@
+#pragma once
+
+namespace Comphi {
+
+	class Transform;
+	class Camera;
+	class Renderer;
+
+	//Compile time list of every Component type, the position in the list is its dense type ID
+	template<typename... Ts>
+	struct ComponentTypeList {
+		static constexpr uint Count = sizeof...(Ts);
+
+		template<typename T>
+		static constexpr uint indexOf() {
+			uint index = 0;
+			bool found = ((std::is_same<T, Ts>::value ? true : (index++, false)) || ...);
+			return found ? index : Count;
+		}
+	};
+
+	//TODO: new components (Light, Script) go here
+	typedef ComponentTypeList<Transform, Camera, Renderer> ComponentTypes;
+
+	constexpr uint MaxComponentTypes = 64;
+	static_assert(ComponentTypes::Count <= MaxComponentTypes, "ComponentMask too small for the ComponentTypes list!");
+
+	template<typename T>
+	constexpr uint ComponentTypeID = ComponentTypes::indexOf<T>();
+
+	typedef uint64 ComponentMask;
+
+	constexpr ComponentMask componentTypeBit(uint typeID) {
+		return ComponentMask(1) << typeID;
+	}
+
+	template<typename... Ts>
+	constexpr ComponentMask ComponentMaskOf = (ComponentMask(0) | ... | componentTypeBit(ComponentTypeID<Ts>));
+
+}
@@ -2,61 +2,81 @@
 #include "Transform.h"
 
 namespace Comphi {
+	Transform::Transform()
+	{
+		node = TransformHierarchy::get()->createNode();
+	}
+
 	Transform::Transform(TransformPtr& parent)
 	{
-		this->parent.reset(parent.get());
+		node = TransformHierarchy::get()->createNode(parent.get() != nullptr ? parent->node : TransformHierarchy::InvalidNode);
+	}
+
+	Transform::Transform(Transform&& other) noexcept
+		: Component(std::move(other)), node(other.node)
+	{
+		other.node = TransformHierarchy::InvalidNode;
+	}
+
+	Transform::~Transform()
+	{
+		cleanUp();
+	}
+
+	void Transform::cleanUp()
+	{
+		if (node == TransformHierarchy::InvalidNode) return;
+		TransformHierarchy::get()->destroyNode(node);
+		node = TransformHierarchy::InvalidNode;
+	}
+
+	void Transform::setParent(TransformPtr& parent)
+	{
+		TransformHierarchy::get()->setParent(node, parent.get() != nullptr ? parent->node : TransformHierarchy::InvalidNode);
 	}
 
 	glm::vec3 Transform::getForwardVector()
 	{
-		if (parent.get() != nullptr) {
-			return quaternionRotation * parent->getForwardVector();
-		}
-		return quaternionRotation * Coordinates::forward;
+		return getRelativeRotation() * Coordinates::forward;
 	}
 
 	glm::vec3 Transform::getUpVector()
 	{
-		if (parent.get() != nullptr) {
-			return  quaternionRotation * parent->getUpVector();
-		}
-		return quaternionRotation * Coordinates::up;
+		return getRelativeRotation() * Coordinates::up;
 	}
 
 	glm::vec3 Transform::getRightVector()
 	{
-		if (parent.get() != nullptr) {
-			return  quaternionRotation * parent->getRightVector();
-		}
-		return quaternionRotation * Coordinates::right;
+		return getRelativeRotation() * Coordinates::right;
 	}
 	
 	glm::vec3 Transform::getLookVector()
 	{
-		if (parent.get() != nullptr) {
-			return  getRelativePosition() + getForwardVector();
-		}
-		return position + getForwardVector();
+		return getRelativePosition() + getForwardVector();
 	}
 
 	glm::vec3 Transform::getEulerAngles()
 	{
-		return glm::eulerAngles(quaternionRotation);
+		return glm::eulerAngles(getRotation());
 	}
 
 	glm::quat Transform::setEulerAngles(glm::vec3 pitchRollYaw)
 	{
-		return quaternionRotation = glm::quat(glm::radians(pitchRollYaw));
+		glm::quat rotation = glm::quat(glm::radians(pitchRollYaw));
+		setRotation(rotation);
+		return rotation;
 	}
 
 	glm::quat Transform::eulerRotation(glm::vec3 pitchYawRoll)
 	{
-		return quaternionRotation *= glm::quat(glm::radians(pitchYawRoll));
+		glm::quat rotation = getRotation() * glm::quat(glm::radians(pitchYawRoll));
+		setRotation(rotation);
+		return rotation;
 	}
 
 	glm::quat Transform::lookAt(glm::vec3 point)
 	{
-		return quaternionRotation; // this is not working = glm::quatLookAt(glm::normalize(point - getRelativePosition()), getUpVector());
+		return getRotation(); // this is not working = glm::quatLookAt(glm::normalize(point - getRelativePosition()), getUpVector());
 		
 		/*glm::quat LookAt(const glm::vec3 & from, const glm::vec3 & to, const glm::vec3 & up)
 		{
@@ -76,44 +96,26 @@ namespace Comphi {
 		//return quaternionRotation = LookAt(getRelativePosition(), point, getUpVector());
 	}
 
-	glm::mat4 Transform::getModelMatrix()
-	{
-		glm::mat4 ModelMatrix = glm::mat4(1.0f);
-
-		ModelMatrix = glm::translate(ModelMatrix, getRelativePosition());
-		ModelMatrix *= glm::toMat4(getRelativeRotation());
-		ModelMatrix = glm::scale(ModelMatrix, getRelativeScale());
-		return ModelMatrix;
-		
-	}
-
 	glm::mat4 Transform::getViewMatrix()
 	{
-		return glm::lookAt(getRelativePosition(), getLookVector(), getUpVector());
+		glm::vec3 worldPosition = getRelativePosition();
+		glm::quat worldRotation = getRelativeRotation();
+		return glm::lookAt(worldPosition, worldPosition + worldRotation * Coordinates::forward, worldRotation * Coordinates::up);
 	}
 
 	glm::vec3 Transform::getRelativePosition()
 	{
-		if (parent.get() != nullptr) {
-			return parent->getRelativePosition() + (parent->quaternionRotation * position);
-		}
-		return position;
+		return glm::vec3(TransformHierarchy::get()->getWorldMatrix(node)[3]);
 	}
 
 	glm::vec3 Transform::getRelativeScale()
 	{
-		if (parent.get() != nullptr) {
-			return parent->getRelativeScale() * scale;
-		}
-		return scale;
+		return TransformHierarchy::get()->getWorldScale(node);
 	}
 
 	glm::quat Transform::getRelativeRotation()
 	{
-		if (parent.get() != nullptr) {
-			return parent->getRelativeRotation() * quaternionRotation;
-		}
-		return quaternionRotation;
+		return TransformHierarchy::get()->getWorldRotation(node);
 	}
 
 }
@@ -1,19 +1,26 @@
 #pragma once
 #include "Component.h"
-#include "../Rendering/ShaderBufferData.h"
+#include "Comphi/API/SceneGraph/TransformHierarchy.h"
 
 namespace Comphi {
 
 	class Transform;
 	typedef std::shared_ptr<Transform> TransformPtr;
 
+	//Handle to a node of the TransformHierarchy, owns the node
 	class Transform : public Component
 	{
 	public:
 		Transform(TransformPtr& parent);
-		Transform() = default;
+		Transform();
+		~Transform();
+		Transform(Transform&& other) noexcept;
+		Transform(const Transform&) = delete;
+		Transform& operator=(const Transform&) = delete;
+		virtual void cleanUp() override;
 
-		TransformPtr parent;
+		void setParent(TransformPtr& parent);
+		inline uint getNode() const { return node; }
 
 		glm::vec3 getForwardVector();
 		glm::vec3 getLookVector();
@@ -25,19 +32,26 @@ namespace Comphi {
 		glm::quat eulerRotation(glm::vec3 pitchRollYaw);
 		glm::quat lookAt(glm::vec3 point);
 
-		glm::mat4 getModelMatrix();
+		//Local space (relative to parent)
+		inline glm::vec3 getPosition() const { return TransformHierarchy::get()->getPosition(node); }
+		inline glm::quat getRotation() const { return TransformHierarchy::get()->getRotation(node); }
+		inline glm::vec3 getScale() const { return TransformHierarchy::get()->getScale(node); }
+		inline void setPosition(const glm::vec3& position) { TransformHierarchy::get()->setPosition(node, position); }
+		inline void setRotation(const glm::quat& rotation) { TransformHierarchy::get()->setRotation(node, rotation); }
+		inline void setScale(const glm::vec3& scale) { TransformHierarchy::get()->setScale(node, scale); }
+
+		//Cached in the TransformHierarchy, only recomputed when this transform or a parent changed
+		inline const glm::mat4& getLocalMatrix() { return TransformHierarchy::get()->getLocalMatrix(node); }
+		inline const glm::mat4& getModelMatrix() { return TransformHierarchy::get()->getWorldMatrix(node); }
 		glm::mat4 getViewMatrix();
-		BufferDataPtr bufferModelMatrix;
 
+		//World space
 		glm::vec3 getRelativePosition();
 		glm::vec3 getRelativeScale();
 		glm::quat getRelativeRotation();
 
-		glm::quat quaternionRotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
-		glm::vec3 position = glm::vec3(0.0f);
-		glm::vec3 scale = glm::vec3(1.0f);
-		//glm::vec3 skew; //in the 4th dimension
-		//glm::vec3 prespective;
+	private:
+		uint node = TransformHierarchy::InvalidNode;
 	};
 
 	namespace Coordinates {
@@ -1,6 +1,7 @@
 #include "cphipch.h"
 #include "Material.h"
 #include "Comphi/Utils/ModelLoader.h"
+#include "Comphi/Core/ThreadPool.h"
 
 namespace Comphi {
 
@@ -95,7 +96,98 @@ namespace Comphi {
 		
 	}
 
+	uint Material::addPushConstantRange(uint size, ShaderStageFlag shaderStage)
+	{
+		auto& pushConstantRanges = configuration.pipelineLayoutConfiguration.pushConstantRanges;
+
+		PushConstantRange range;
+		range.shaderStage = shaderStage;
+		range.offset = pushConstantRanges.empty() ? 0 : pushConstantRanges.back().offset + pushConstantRanges.back().size;
+		range.size = (size + 3) & ~3u; //4 byte aligned
+
+		if (range.offset + range.size > PipelineLayoutConfiguration::MaxPushConstantsSize) {
+			COMPHILOG_CORE_ERROR("addPushConstantRange: push constants exceed {0} bytes!", PipelineLayoutConfiguration::MaxPushConstantsSize);
+			return PipelineLayoutConfiguration::InvalidPushConstantOffset;
+		}
+
+		pushConstantRanges.push_back(range);
+		return range.offset;
+	}
+
 	
 
 
+	struct SharedPipeline {
+		std::string configurationKey; //compared on hash hits
+		std::weak_ptr<IGraphicsPipeline> pipeline; //owned by the materials using it
+	};
+
+	//process wide, entries are dropped once no material holds their pipeline anymore
+	//and all at once by releaseSharedPipelines (the object pool destroyed every pipeline)
+	static std::unordered_map<uint64_t, SharedPipeline> sharedPipelines;
+	static std::mutex sharedPipelinesMutex;
+
+	void Material::initialize()
+	{
+		ready = false;
+
+		std::string configurationKey = configuration.getCanonicalKey();
+		uint64_t configurationHash = std::hash<std::string>()(configurationKey);
+		{
+			std::lock_guard<std::mutex> lock(sharedPipelinesMutex);
+			for (auto it = sharedPipelines.begin(); it != sharedPipelines.end();) {
+				if (it->second.pipeline.expired()) it = sharedPipelines.erase(it);
+				else it++;
+			}
+
+			auto sharedPipeline = sharedPipelines.find(configurationHash);
+			IGraphicsPipelinePtr existingPipeline = sharedPipeline != sharedPipelines.end() ? sharedPipeline->second.pipeline.lock() : nullptr;
+			if (existingPipeline == nullptr) {
+				//new configuration, or released by another thread since the sweep
+				sharedPipelines[configurationHash] = { configurationKey, pipeline };
+			}
+			else if (sharedPipeline->second.configurationKey == configurationKey) {
+				//the pipeline created for this material stays uninitialized
+				pipeline = existingPipeline;
+				COMPHILOG_CORE_INFO("Material: reusing pipeline with configuration hash {0}", configurationHash);
+				return;
+			}
+			else {
+				//hash collision : compiled on its own, not shared
+				COMPHILOG_CORE_WARN("Material: configuration hash {0} collides with a different pipeline", configurationHash);
+			}
+		}
+
+		pipeline->configuration = configuration;
+
+		IGraphicsPipelinePtr compiledPipeline = pipeline;
+		pipeline->compilation = ThreadPool::get()->submitBackground([compiledPipeline]() {
+			compiledPipeline->initialize();
+		}).share();
+	}
+
+	bool Material::isReady()
+	{
+		if (ready) return true;
+		if (!pipeline->compilation.valid()) return false;
+		if (pipeline->compilation.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+
+		waitUntilReady();
+		return true;
+	}
+
+	void Material::releaseSharedPipelines()
+	{
+		std::lock_guard<std::mutex> lock(sharedPipelinesMutex);
+		sharedPipelines.clear();
+	}
+
+	void Material::waitUntilReady()
+	{
+		if (!pipeline->compilation.valid()) return;
+		pipeline->compilation.get();
+		configuration = pipeline->configuration;
+		ready = true;
+	}
+
 }
\ No newline at end of file
@@ -21,19 +21,37 @@ namespace Comphi {
 		inline void addVertexAttribute(uint layoutBindingID, uint layoutLocationID, const M T::* member, PixelFormat format = R_F32);
 
 		void addShader(ShaderObjectPtr shaderObject);
+		//UniformBufferDynamic / StorageBufferDynamic bindings get their offset when the set is bound
 		void createShaderResourceLayoutSetDescriptorSetBinding(LayoutSetUpdateFrequency layoutSetID, uint bindingID, uint resourceDescriptorSetCount, DescriptorSetResourceType type = UniformBufferData, ShaderStageFlag shaderStage = ShaderStageFlag::AllGraphics);
 
-		virtual void initialize() override {
-			pipeline->configuration = configuration;
-			pipeline->initialize(); 
-			configuration = pipeline->configuration;
-		};
+		//compile time variant of the stage (texture on/off, light count, alpha test...), part of the pipeline hash
+		//T : bool, int32_t, uint32_t or float, matching the shader's constant_id declaration
+		template<typename T>
+		inline void setSpecializationConstant(ShaderType stage, uint constantID, T value) {
+			configuration.specializationConstants[stage][constantID] = SpecializationConstant(value);
+		}
+
+		//declares a push constant block after the previous ones (the first one is the renderer's DrawPushConstants), returns its offset
+		//or PipelineLayoutConfiguration::InvalidPushConstantOffset when it doesn't fit (nothing is declared)
+		//values are written per draw while recording (GraphicsPipeline::pushConstants), they are not stored in the material
+		uint addPushConstantRange(uint size, ShaderStageFlag shaderStage = ShaderStageFlag::AllGraphics);
+
+		//compiles the pipeline on a background worker, batches using the material are skipped until isReady()
+		//materials with the same configuration (canonical key) share one pipeline (compiled once), initialize a material only once
+		virtual void initialize() override;
+		bool isReady();
+		//blocks until compiled, rethrows compilation errors
+		void waitUntilReady();
+
+		//forgets every shared pipeline, called when the object pool destroyed them
+		static void releaseSharedPipelines();
 
 		IGraphicsPipelinePtr getIPipelinePtr() {
 			return pipeline;
 		}
 	private:
 		IGraphicsPipelinePtr pipeline;
+		bool ready = false;
 	};
 
 	typedef std::shared_ptr<Material> MaterialPtr;
@@ -1,6 +1,7 @@
 #include "cphipch.h"
 #include "MeshObject.h"
-#include "Comphi/Renderer/Vulkan/Buffers/UniformBuffer.h"
+#include "Comphi/Renderer/Vulkan/Buffers/GeometryPool.h"
+#include "Comphi/Renderer/Vulkan/Memory/DeferredDeletionQueue.h"
 
 namespace Comphi {
 
@@ -39,11 +40,32 @@ namespace Comphi {
 
 	void MeshObject::initMeshBuffers()
 	{
-		meshBuffers.vertexBuffer = std::make_shared<Vulkan::UniformBuffer>(meshData.vertexData.data(), sizeof(meshData.vertexData[0]), meshData.vertexData.size(), BufferUsage::VertexBuffer);
-		meshBuffers.vertexBuffer->updateBufferData(meshData.vertexData.data());
-		
-		meshBuffers.indexBuffer = std::make_shared<Vulkan::UniformBuffer>(meshData.indexData.data(), sizeof(meshData.indexData[0]), meshData.indexData.size(), BufferUsage::IndexBuffer);
-		meshBuffers.indexBuffer->updateBufferData(meshData.indexData.data());
+		Vulkan::GeometryAllocation geometry = Vulkan::GeometryPool::get()->allocate(meshData.vertexData, meshData.indexData);
+		meshBuffers.vertexBuffer = geometry.vertexBuffer;
+		meshBuffers.indexBuffer = geometry.indexBuffer;
+		meshBuffers.vertexOffset = geometry.vertexOffset;
+		meshBuffers.firstIndex = geometry.firstIndex;
+		meshBuffers.pageIndex = geometry.pageIndex;
+	}
+
+	void MeshObject::cleanUp()
+	{
+		if (meshBuffers.vertexBuffer.get() == nullptr) return;
+
+		Vulkan::GeometryAllocation geometry;
+		geometry.vertexBuffer = std::static_pointer_cast<Vulkan::UniformBuffer>(meshBuffers.vertexBuffer);
+		geometry.indexBuffer = std::static_pointer_cast<Vulkan::UniformBuffer>(meshBuffers.indexBuffer);
+		geometry.vertexOffset = meshBuffers.vertexOffset;
+		geometry.vertexCount = (uint)meshData.vertexData.size();
+		geometry.firstIndex = meshBuffers.firstIndex;
+		geometry.indexCount = (uint)meshData.indexData.size();
+		geometry.pageIndex = meshBuffers.pageIndex;
+		//in flight frames may still draw from the range : it is returned to the pool once they complete
+		Vulkan::DeferredDeletionQueue::get()->enqueue([geometry]() mutable {
+			Vulkan::GeometryPool::get()->free(geometry);
+		});
+
+		meshBuffers = MeshBuffers();
 	}
 
 }
@@ -5,9 +5,13 @@
 
 namespace Comphi {
 
+	//vertex/index buffers are shared GeometryPool pages, the mesh is the range at vertexOffset/firstIndex
 	struct MeshBuffers{
 		BufferDataPtr vertexBuffer;
 		BufferDataPtr indexBuffer;
+		uint vertexOffset = 0;
+		uint firstIndex = 0;
+		uint pageIndex = 0;
 	};
 
 	//template<typename vx = Vertex, typename ix = Index>
@@ -21,7 +25,7 @@ namespace Comphi {
 
 		MeshData meshData;
 		MeshBuffers meshBuffers;
-		virtual void cleanUp() override {};
+		virtual void cleanUp() override; //releases the GeometryPool range
 
 		//typedef std::shared_ptr<MeshObject<vx, ix>> Ptr;
 
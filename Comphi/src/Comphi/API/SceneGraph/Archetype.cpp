@@ -0,0 +1,119 @@
+#include "cphipch.h"
+#include "Archetype.h"
+
+namespace Comphi {
+
+	static inline size_t alignUp(size_t offset, size_t alignment) {
+		return (offset + alignment - 1) & ~(alignment - 1);
+	}
+
+	ArchetypeChunk::ArchetypeChunk(const Archetype& archetype)
+	{
+		alignment = archetype.chunkAlignment;
+		data = static_cast<std::byte*>(::operator new(archetype.chunkByteSize, std::align_val_t(alignment)));
+		entities = reinterpret_cast<EntityID*>(data + archetype.entitiesOffset);
+	}
+
+	ArchetypeChunk::~ArchetypeChunk()
+	{
+		::operator delete(data, std::align_val_t(alignment));
+	}
+
+	Archetype::Archetype(const ComponentTypeSet& types) : types(types)
+	{
+		columnSlots.fill(-1);
+		for (size_t i = 0; i < types.size(); i++)
+		{
+			columnSlots[types[i]->typeID] = (int)i;
+			mask |= componentTypeBit(types[i]->typeID);
+		}
+
+		chunkAlignment = alignof(EntityID);
+		size_t rowByteSize = sizeof(EntityID);
+		size_t paddingSlack = 0;
+		for (auto& type : types) {
+			chunkAlignment = (std::max)(chunkAlignment, type->alignment);
+			rowByteSize += type->size;
+			paddingSlack += type->alignment;
+		}
+
+		//fit as many rows as possible in a chunk, oversized components get one row per chunk
+		rowCapacity = (uint)(std::max<size_t>)(1, (ChunkByteSize - (std::min)(ChunkByteSize, paddingSlack)) / rowByteSize);
+
+		size_t offset = 0;
+		columnOffsets.resize(types.size());
+		for (size_t i = 0; i < types.size(); i++)
+		{
+			offset = alignUp(offset, types[i]->alignment);
+			columnOffsets[i] = offset;
+			offset += types[i]->size * rowCapacity;
+		}
+		offset = alignUp(offset, alignof(EntityID));
+		entitiesOffset = offset;
+		offset += sizeof(EntityID) * rowCapacity;
+
+		chunkByteSize = alignUp(offset, chunkAlignment);
+	}
+
+	Archetype::~Archetype()
+	{
+		for (auto& chunk : chunks) {
+			for (uint row = 0; row < chunk->count; row++) {
+				for (size_t column = 0; column < types.size(); column++) {
+					types[column]->destroy(chunk->getComponent(columnOffsets[column], types[column]->size, row));
+				}
+			}
+		}
+		chunks.clear();
+	}
+
+	EntityLocation Archetype::allocateRow(EntityID entity)
+	{
+		//chunks are kept dense, only the last one can have free rows
+		if (chunks.empty() || chunks.back()->count == rowCapacity) {
+			chunks.push_back(std::make_unique<ArchetypeChunk>(*this));
+		}
+
+		auto& chunk = *chunks.back();
+		EntityLocation location = { (uint)chunks.size() - 1, chunk.count };
+		chunk.entities[chunk.count] = entity;
+		chunk.count++;
+		entityCount++;
+		return location;
+	}
+
+	EntityID Archetype::removeRow(const EntityLocation& location)
+	{
+		auto& chunk = *chunks[location.chunk];
+		auto& lastChunk = *chunks.back();
+		uint lastRow = lastChunk.count - 1;
+		bool isLastRow = (&chunk == &lastChunk) && location.row == lastRow;
+
+		EntityID movedEntity;
+		for (size_t column = 0; column < types.size(); column++)
+		{
+			auto& type = types[column];
+			void* dst = chunk.getComponent(columnOffsets[column], type->size, location.row);
+			type->destroy(dst);
+
+			if (!isLastRow) {
+				void* src = lastChunk.getComponent(columnOffsets[column], type->size, lastRow);
+				type->moveConstruct(dst, src);
+				type->destroy(src);
+			}
+		}
+
+		if (!isLastRow) {
+			movedEntity = lastChunk.entities[lastRow];
+			chunk.entities[location.row] = movedEntity;
+		}
+
+		lastChunk.count--;
+		entityCount--;
+		if (lastChunk.count == 0) {
+			chunks.pop_back();
+		}
+		return movedEntity;
+	}
+
+}
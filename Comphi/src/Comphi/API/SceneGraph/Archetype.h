@@ -0,0 +1,122 @@
+#pragma once
+#include "Comphi/API/Components/Component.h"
+#include "Comphi/API/Components/ComponentRegistry.h"
+
+namespace Comphi {
+
+	struct EntityID {
+		static constexpr uint InvalidIndex = UINT32_MAX;
+		uint index = InvalidIndex;
+		uint generation = 0;
+
+		inline bool isValid() const { return index != InvalidIndex; }
+		bool operator==(const EntityID& other) const {
+			return index == other.index && generation == other.generation;
+		}
+	};
+
+	//Type erased description of a Component type, one static instance per type
+	struct ComponentTypeInfo {
+		uint typeID;
+		size_t size;
+		size_t alignment;
+		void(*moveConstruct)(void* dst, void* src);
+		void(*destroy)(void* ptr);
+
+		template<typename T>
+		static const ComponentTypeInfo* of() {
+			static_assert(std::is_base_of<Component, T>::value, "Sub-Component not derived from BaseClass Component!");
+			static_assert(ComponentTypeID<T> < ComponentTypes::Count, "Component not registered in ComponentTypes!");
+			static const ComponentTypeInfo info = {
+				ComponentTypeID<T>,
+				sizeof(T),
+				alignof(T),
+				[](void* dst, void* src) { new (dst) T(std::move(*static_cast<T*>(src))); },
+				[](void* ptr) { static_cast<T*>(ptr)->~T(); }
+			};
+			return &info;
+		}
+	};
+
+	typedef std::vector<const ComponentTypeInfo*> ComponentTypeSet; //sorted by typeID
+
+	class Archetype;
+
+	//Fixed size block of memory holding rowCapacity entities of one Archetype
+	//Each component type is laid out contiguously (SoA): [T0 T0 T0 ...][T1 T1 T1 ...][EntityID ...]
+	class ArchetypeChunk
+	{
+	public:
+		ArchetypeChunk(const Archetype& archetype);
+		~ArchetypeChunk();
+		ArchetypeChunk(const ArchetypeChunk&) = delete;
+		ArchetypeChunk& operator=(const ArchetypeChunk&) = delete;
+
+		inline void* getComponent(size_t columnOffset, size_t componentSize, uint row) {
+			return data + columnOffset + componentSize * row;
+		}
+
+		std::byte* data;
+		EntityID* entities;
+		uint count = 0;
+	private:
+		size_t alignment;
+	};
+
+	struct EntityLocation {
+		uint chunk;
+		uint row;
+	};
+
+	//Unique set of component types, owns the chunks of every entity that has exactly that set
+	class Archetype
+	{
+	public:
+		static constexpr size_t ChunkByteSize = 16 * 1024;
+
+		Archetype(const ComponentTypeSet& types);
+		~Archetype();
+
+		//-1 if the type is not part of this archetype
+		inline int getColumnIndex(uint typeID) const { return columnSlots[typeID]; }
+		inline bool hasType(uint typeID) const { return (mask & componentTypeBit(typeID)) != 0; }
+		inline bool hasTypes(ComponentMask query) const { return (mask & query) == query; }
+
+		inline void* getComponent(uint column, const EntityLocation& location) {
+			return chunks[location.chunk]->getComponent(columnOffsets[column], types[column]->size, location.row);
+		}
+
+		template<typename T>
+		inline T* getColumn(uint column, ArchetypeChunk& chunk) {
+			return reinterpret_cast<T*>(chunk.data + columnOffsets[column]);
+		}
+
+		//reserves a row at the end of the archetype, components are left unconstructed
+		EntityLocation allocateRow(EntityID entity);
+		//destroys the row components and fills the hole with the last row of the archetype
+		//returns the entity that was moved into location (invalid if none)
+		EntityID removeRow(const EntityLocation& location);
+
+		inline uint getEntityCount() const { return entityCount; }
+
+		const ComponentTypeSet types;
+		ComponentMask mask = 0;
+		std::array<int, MaxComponentTypes> columnSlots; //typeID -> column
+		std::vector<std::unique_ptr<ArchetypeChunk>> chunks;
+
+		//Archetype graph cache (typeID added / removed -> destination archetype)
+		std::array<Archetype*, MaxComponentTypes> addEdges = {};
+		std::array<Archetype*, MaxComponentTypes> removeEdges = {};
+
+		//Chunk Layout
+		uint rowCapacity;
+		size_t chunkByteSize;
+		size_t chunkAlignment;
+		size_t entitiesOffset;
+		std::vector<size_t> columnOffsets;
+
+	private:
+		uint entityCount = 0;
+	};
+
+}
@@ -6,5 +6,21 @@
 
 namespace Comphi {
    
+	Entity::Entity()
+	{
+		entityID = EntityRegistry::get()->createEntity();
+	}
 
-}
\ No newline at end of file
+	Entity::~Entity()
+	{
+		cleanUp();
+	}
+
+	void Entity::cleanUp()
+	{
+		if (!entityID.isValid()) return;
+		EntityRegistry::get()->destroyEntity(entityID);
+		entityID = EntityID();
+	}
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "Comphi/API/Components/Component.h"
 #include "Comphi/Utils/Time.h"
+#include "EntityRegistry.h"
 
 namespace Comphi {
 
@@ -12,48 +13,64 @@ namespace Comphi {
 		//LateUpdate
 	};
 
+	//Facade over the EntityRegistry, components live in archetype chunks (SoA)
 	class Entity : public IObject
 	{
 	public:
-		Entity() = default;
-		~Entity() = default;
-		virtual void cleanUp() override {}; //TODO : Implement cleanupOfSubcomponents
+		Entity();
+		~Entity();
+		Entity(const Entity&) = delete;
+		Entity& operator=(const Entity&) = delete;
+		virtual void cleanUp() override;
 		
+		//componentPtr is moved into the entity storage
+		//Returned pointers are non-owning and valid until the next structural change of the entity archetype
+		//(any entity of it added, destroyed or gaining/losing a component), fetch them again instead of keeping them
 		template<typename T>
-		std::shared_ptr<T>& AddComponent(std::shared_ptr<T> componentPtr);
+		T* AddComponent(std::shared_ptr<T> componentPtr);
 
 		template<typename T>
-		std::shared_ptr<T> GetComponent();
-		
-		std::vector<ComponentPtr> componentList;
-		//Todo: O(1) >> std::unordered_map<std::shared_ptr<Component>,someHash> componentList;
+		T* GetComponent();
+
+		template<typename T>
+		bool HasComponent();
+
+		template<typename T>
+		void RemoveComponent();
+
+		inline ComponentMask getComponentMask() const { return EntityRegistry::get()->getComponentMask(entityID); }
+		inline EntityID getID() const { return entityID; }
+
+	private:
+		EntityID entityID;
 	};
 
 	typedef std::shared_ptr<Entity> EntityPtr;
 
 
 	template<typename T>
-	std::shared_ptr<T>& Entity::AddComponent(std::shared_ptr<T> componentPtr)
+	T* Entity::AddComponent(std::shared_ptr<T> componentPtr)
 	{
 		//sanity-Check
 		static_assert(std::is_base_of<Component, T>::value, "Sub-Component not derived from BaseClass Component!");
-		//componentPtr->ownerEntity = this;
-		componentList.push_back(componentPtr);
-		return componentPtr;
+		return EntityRegistry::get()->addComponent<T>(entityID, std::move(*componentPtr));
 	}
 
 	template<typename T>
-	std::shared_ptr<T> Entity::GetComponent()
+	T* Entity::GetComponent()
 	{
-		for (size_t i = 0; i < componentList.size(); i++)
-		{
-			//Find castable component O(N)
-			T* componentPtr = dynamic_cast<T*>(componentList[i].get());
-			if (componentPtr != nullptr) {
-				return (std::static_pointer_cast<T>(componentList[i]));
-			}
-		}
-		return nullptr;
+		return EntityRegistry::get()->getComponent<T>(entityID);
 	}
-}
 
+	template<typename T>
+	bool Entity::HasComponent()
+	{
+		return EntityRegistry::get()->hasComponent<T>(entityID);
+	}
+
+	template<typename T>
+	void Entity::RemoveComponent()
+	{
+		EntityRegistry::get()->removeComponent<T>(entityID);
+	}
+}
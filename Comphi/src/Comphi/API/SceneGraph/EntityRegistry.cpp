@@ -0,0 +1,169 @@
+#include "cphipch.h"
+#include "EntityRegistry.h"
+
+namespace Comphi {
+
+	EntityRegistry* EntityRegistry::get()
+	{
+		static EntityRegistry entityRegistry;
+		return &entityRegistry;
+	}
+
+	EntityRegistry::EntityRegistry()
+	{
+		emptyArchetype = getArchetype({});
+	}
+
+	EntityID EntityRegistry::createEntity()
+	{
+		EntityID entity;
+		if (!freeIndices.empty()) {
+			entity.index = freeIndices.back();
+			freeIndices.pop_back();
+		}
+		else {
+			entity.index = (uint)records.size();
+			records.push_back(EntityRecord());
+		}
+
+		auto& record = records[entity.index];
+		entity.generation = record.generation;
+		record.archetype = emptyArchetype;
+		record.location = emptyArchetype->allocateRow(entity);
+		return entity;
+	}
+
+	void EntityRegistry::destroyEntity(EntityID entity)
+	{
+		if (!isAlive(entity)) return;
+
+		auto& record = records[entity.index];
+		removeEntityRow(record);
+		record.archetype = nullptr;
+		record.generation++;
+		freeIndices.push_back(entity.index);
+	}
+
+	void* EntityRegistry::addComponent(EntityID entity, const ComponentTypeInfo* type, void* component)
+	{
+		if (!isAlive(entity)) {
+			COMPHILOG_CORE_ERROR("addComponent: entity {0} is not alive!", entity.index);
+			return nullptr;
+		}
+
+		auto& record = records[entity.index];
+		int column = record.archetype->getColumnIndex(type->typeID);
+		if (column != -1) {
+			void* dst = record.archetype->getComponent(column, record.location);
+			type->destroy(dst);
+			type->moveConstruct(dst, component);
+			return dst;
+		}
+
+		moveEntity(entity, getAddArchetype(record.archetype, type));
+		column = record.archetype->getColumnIndex(type->typeID);
+		void* dst = record.archetype->getComponent(column, record.location);
+		type->moveConstruct(dst, component);
+		return dst;
+	}
+
+	void EntityRegistry::removeComponent(EntityID entity, const ComponentTypeInfo* type)
+	{
+		if (!isAlive(entity)) return;
+
+		auto& record = records[entity.index];
+		if (!record.archetype->hasType(type->typeID)) return;
+		moveEntity(entity, getRemoveArchetype(record.archetype, type));
+	}
+
+	Archetype* EntityRegistry::getArchetype(const ComponentTypeSet& types)
+	{
+		ComponentMask mask = 0;
+		for (auto& type : types) {
+			mask |= componentTypeBit(type->typeID);
+		}
+
+		auto& archetype = archetypes[mask];
+		if (archetype.get() == nullptr) {
+			archetype = std::make_unique<Archetype>(types);
+		}
+		return archetype.get();
+	}
+
+	Archetype* EntityRegistry::getAddArchetype(Archetype* archetype, const ComponentTypeInfo* type)
+	{
+		Archetype*& edge = archetype->addEdges[type->typeID];
+		if (edge != nullptr) return edge;
+
+		ComponentTypeSet types = archetype->types;
+		auto byTypeID = [](const ComponentTypeInfo* a, const ComponentTypeInfo* b) { return a->typeID < b->typeID; };
+		types.insert(std::upper_bound(types.begin(), types.end(), type, byTypeID), type);
+		Archetype* dstArchetype = getArchetype(types);
+
+		edge = dstArchetype;
+		dstArchetype->removeEdges[type->typeID] = archetype;
+		return dstArchetype;
+	}
+
+	Archetype* EntityRegistry::getRemoveArchetype(Archetype* archetype, const ComponentTypeInfo* type)
+	{
+		Archetype*& edge = archetype->removeEdges[type->typeID];
+		if (edge != nullptr) return edge;
+
+		ComponentTypeSet types = archetype->types;
+		types.erase(std::find(types.begin(), types.end(), type));
+		Archetype* dstArchetype = getArchetype(types);
+
+		edge = dstArchetype;
+		dstArchetype->addEdges[type->typeID] = archetype;
+		return dstArchetype;
+	}
+
+	//Moves the shared components to dstArchetype, the ones missing in dstArchetype are destroyed
+	//components only present in dstArchetype are left unconstructed for the caller
+	void EntityRegistry::moveEntity(EntityID entity, Archetype* dstArchetype)
+	{
+		auto& record = records[entity.index];
+		Archetype* srcArchetype = record.archetype;
+		EntityLocation dstLocation = dstArchetype->allocateRow(entity);
+
+		for (size_t srcColumn = 0; srcColumn < srcArchetype->types.size(); srcColumn++)
+		{
+			int dstColumn = dstArchetype->getColumnIndex(srcArchetype->types[srcColumn]->typeID);
+			if (dstColumn == -1) continue;
+			srcArchetype->types[srcColumn]->moveConstruct(
+				dstArchetype->getComponent(dstColumn, dstLocation),
+				srcArchetype->getComponent((uint)srcColumn, record.location)
+			);
+		}
+
+		removeEntityRow(record);
+		record.archetype = dstArchetype;
+		record.location = dstLocation;
+	}
+
+	void EntityRegistry::removeEntityRow(EntityRecord& record)
+	{
+		EntityID movedEntity = record.archetype->removeRow(record.location);
+		if (movedEntity.isValid()) {
+			records[movedEntity.index].location = record.location;
+		}
+	}
+
+	void EntityRegistry::clear()
+	{
+		archetypes.clear();
+		emptyArchetype = getArchetype({});
+
+		//keep generations so stale handles stay invalid
+		for (uint index = 0; index < records.size(); index++)
+		{
+			auto& record = records[index];
+			if (record.archetype == nullptr) continue;
+			record.archetype = nullptr;
+			record.generation++;
+			freeIndices.push_back(index);
+		}
+	}
+
+}
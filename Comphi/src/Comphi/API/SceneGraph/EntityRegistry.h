@@ -0,0 +1,145 @@
+#pragma once
+#include "Archetype.h"
+
+namespace Comphi {
+
+	//Owns all component data, grouped by Archetype in SoA chunks
+	//Entities are generational handles to a (archetype, chunk, row) record
+	class EntityRegistry
+	{
+	public:
+		EntityRegistry();
+		~EntityRegistry() = default;
+		static EntityRegistry* get();
+
+		EntityID createEntity();
+		void destroyEntity(EntityID entity);
+		inline bool isAlive(EntityID entity) const;
+
+		//Moves the component into the entity storage (replaces it if already present)
+		//Returned pointer is valid until the next structural change of the entity archetype : rows are swap-removed,
+		//so any entity of it being added, destroyed or gaining/losing a component can move this entity row
+		template<typename T>
+		T* addComponent(EntityID entity, T&& component);
+
+		template<typename T>
+		T* getComponent(EntityID entity);
+
+		template<typename T>
+		bool hasComponent(EntityID entity);
+
+		inline ComponentMask getComponentMask(EntityID entity) const;
+
+		template<typename T>
+		void removeComponent(EntityID entity);
+
+		//fn(EntityID, Ts&...) for every entity that has all Ts
+		//Adding/Removing components or entities inside fn is not allowed
+		template<typename... Ts, typename Fn>
+		void forEach(Fn&& fn);
+
+		void clear();
+
+	private:
+		struct EntityRecord {
+			Archetype* archetype = nullptr;
+			EntityLocation location = {};
+			uint generation = 0;
+		};
+
+		void* addComponent(EntityID entity, const ComponentTypeInfo* type, void* component);
+		inline void* getComponent(EntityID entity, uint typeID);
+		void removeComponent(EntityID entity, const ComponentTypeInfo* type);
+
+		Archetype* getArchetype(const ComponentTypeSet& types);
+		Archetype* getAddArchetype(Archetype* archetype, const ComponentTypeInfo* type);
+		Archetype* getRemoveArchetype(Archetype* archetype, const ComponentTypeInfo* type);
+		void moveEntity(EntityID entity, Archetype* dstArchetype);
+		void removeEntityRow(EntityRecord& record);
+
+		template<typename... Ts, typename Fn, size_t... I>
+		void forEachChunk(Archetype& archetype, ArchetypeChunk& chunk, const int* columns, Fn& fn, std::index_sequence<I...>);
+
+		std::vector<EntityRecord> records;
+		std::vector<uint> freeIndices;
+		std::unordered_map<ComponentMask, std::unique_ptr<Archetype>> archetypes;
+		Archetype* emptyArchetype;
+	};
+
+	inline bool EntityRegistry::isAlive(EntityID entity) const
+	{
+		return entity.index < records.size()
+			&& records[entity.index].generation == entity.generation
+			&& records[entity.index].archetype != nullptr;
+	}
+
+	inline ComponentMask EntityRegistry::getComponentMask(EntityID entity) const
+	{
+		if (!isAlive(entity)) return 0;
+		return records[entity.index].archetype->mask;
+	}
+
+	template<typename T>
+	T* EntityRegistry::addComponent(EntityID entity, T&& component)
+	{
+		return static_cast<T*>(addComponent(entity, ComponentTypeInfo::of<T>(), &component));
+	}
+
+	inline void* EntityRegistry::getComponent(EntityID entity, uint typeID)
+	{
+		if (!isAlive(entity)) return nullptr;
+
+		auto& record = records[entity.index];
+		int column = record.archetype->getColumnIndex(typeID);
+		if (column == -1) return nullptr;
+		return record.archetype->getComponent(column, record.location);
+	}
+
+	template<typename T>
+	T* EntityRegistry::getComponent(EntityID entity)
+	{
+		static_assert(ComponentTypeID<T> < ComponentTypes::Count, "Component not registered in ComponentTypes!");
+		return static_cast<T*>(getComponent(entity, ComponentTypeID<T>));
+	}
+
+	template<typename T>
+	bool EntityRegistry::hasComponent(EntityID entity)
+	{
+		static_assert(ComponentTypeID<T> < ComponentTypes::Count, "Component not registered in ComponentTypes!");
+		return (getComponentMask(entity) & componentTypeBit(ComponentTypeID<T>)) != 0;
+	}
+
+	template<typename T>
+	void EntityRegistry::removeComponent(EntityID entity)
+	{
+		removeComponent(entity, ComponentTypeInfo::of<T>());
+	}
+
+	template<typename... Ts, typename Fn>
+	void EntityRegistry::forEach(Fn&& fn)
+	{
+		static_assert(sizeof...(Ts) > 0, "forEach requires at least one Component type");
+		constexpr ComponentMask query = ComponentMaskOf<Ts...>;
+
+		for (auto& [mask, archetype] : archetypes) {
+			if (archetype->getEntityCount() == 0 || !archetype->hasTypes(query)) continue;
+
+			const int columns[] = { archetype->getColumnIndex(ComponentTypeID<Ts>)... };
+
+			for (auto& chunk : archetype->chunks) {
+				forEachChunk<Ts...>(*archetype, *chunk, columns, fn, std::index_sequence_for<Ts...>{});
+			}
+		}
+	}
+
+	template<typename... Ts, typename Fn, size_t... I>
+	void EntityRegistry::forEachChunk(Archetype& archetype, ArchetypeChunk& chunk, const int* columns, Fn& fn, std::index_sequence<I...>)
+	{
+		std::tuple<Ts*...> componentColumns = { archetype.getColumn<Ts>(columns[I], chunk)... };
+		for (uint row = 0; row < chunk.count; row++)
+		{
+			fn(chunk.entities[row], std::get<I>(componentColumns)[row]...);
+		}
+	}
+
+}
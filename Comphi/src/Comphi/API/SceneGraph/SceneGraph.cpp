@@ -6,24 +6,21 @@ namespace Comphi {
 	void SceneGraph::addEntity(EntityPtr& entity)
 	{
 
-		auto transform = entity->GetComponent<Transform>();
-		auto cam = entity->GetComponent<Camera>();
-		auto renderer = entity->GetComponent<Renderer>();
+		ComponentMask components = entity->getComponentMask();
 
-		if (cam.get() != nullptr) {
+		if ((components & ComponentMaskOf<Camera, Transform>) == ComponentMaskOf<Camera, Transform>) {
 
-			if (transform.get() != nullptr) {
-
-				RenderCamera camera{
-					cam,transform
-				};
+			RenderCamera camera{
+				entity
+			};
 
-				cameras.push_back(camera);
-			}
+			cameras.push_back(camera);
 		}
 		
 
-		if (renderer.get() != nullptr) {
+		if (components & ComponentMaskOf<Renderer>) {
+
+			auto renderer = entity->GetComponent<Renderer>();
 
 			RenderBatch renderBatch = { 
 				renderer->material->parent,
@@ -46,6 +43,7 @@ namespace Comphi {
 
 			//else Found
 			auto& batchID = const_cast<RenderBatch&>(*batch);
+			batchID.membershipVersion++;
 			auto meshInstance = batchID.renderMeshInstances.find(renderMeshInstance);
 
 			//if batch found but no instance, add instance to batch
@@ -2,6 +2,7 @@
 #include "Comphi/API/Components/Camera.h"
 #include "Comphi/API/Components/Renderer.h"
 #include "Comphi/API/Components/Transform.h"
+#include "Comphi/API/Rendering/ShaderBufferData.h"
 #include "Entity.h"
 #include <set>
 #include "Comphi/Utils/Random.h"
@@ -13,8 +14,9 @@ namespace Comphi {
 	//Mesh + Material + MaterialInstancing = Mesh Instancing
 	//Material + MaterialInstancing - Mesh = Batch Rendering
 
+	//shared_ptrs are held by value : the Renderer components they come from move with archetype changes
 	struct RenderMeshInstance {
-		MeshObjectPtr& meshObject;
+		MeshObjectPtr meshObject;
 
 		std::vector<EntityPtr> instancedMeshEntities;
 
@@ -36,13 +38,30 @@ namespace std {
 
 namespace Comphi{
 	struct RenderBatch {
-		MaterialPtr& material;
-		MaterialInstancePtr& materialInstance;
+		MaterialPtr material;
+		MaterialInstancePtr materialInstance;
 		
 		uint64_t UID = Comphi::Random::hash_combine(0, material->UID, materialInstance->UID);
 		
 		std::unordered_set<RenderMeshInstance> renderMeshInstances;
 
+		//model matrices of every instance grouped by mesh (GPU instancing), one buffer per frame in flight
+		std::vector<BufferDataPtr> instanceBuffers;
+
+		//one indexed indirect draw command per mesh group, one buffer per frame in flight
+		//rebuilt only when membershipVersion changes (entities added to the batch)
+		std::vector<BufferDataPtr> drawCommandBuffers;
+		std::vector<uint> drawCommandVersions;
+		uint membershipVersion = 1;
+
+		inline uint getInstanceCount() const {
+			uint count = 0;
+			for (const auto& meshInstance : renderMeshInstances) {
+				count += (uint)meshInstance.instancedMeshEntities.size();
+			}
+			return count;
+		}
+
 		bool operator==(const RenderBatch& other) const {
 			return other.UID == UID;
 		}
@@ -61,8 +80,11 @@ namespace Comphi {
 
 	struct RenderCamera {
 	public:
-		CameraPtr camera;
-		TransformPtr transform;
+		EntityPtr entity;
+
+		//fetched from the EntityRegistry, components may move in memory
+		inline Camera* camera() const { return entity->GetComponent<Camera>(); }
+		inline Transform* transform() const { return entity->GetComponent<Transform>(); }
 		//void updateViewProjectionMx() {
 		//	glm::mat4 viewProjectionMx = glm::mat4(camera->getProjectionMatrix() * transform->getViewMatrix());
 		//	camera->bufferPMatrix->updateBufferData(&viewProjectionMx);
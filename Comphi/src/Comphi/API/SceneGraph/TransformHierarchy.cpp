@@ -0,0 +1,305 @@
+#include "cphipch.h"
+#include "TransformHierarchy.h"
+#include "Comphi/Core/ThreadPool.h"
+
+namespace Comphi {
+
+	TransformHierarchy* TransformHierarchy::get()
+	{
+		static TransformHierarchy transformHierarchy;
+		return &transformHierarchy;
+	}
+
+	uint TransformHierarchy::createNode(uint parentNode)
+	{
+		uint node;
+		if (!freeNodes.empty()) {
+			node = freeNodes.back();
+			freeNodes.pop_back();
+		}
+		else {
+			node = (uint)nodeToDense.size();
+			nodeToDense.push_back(InvalidNode);
+		}
+
+		uint denseIndex = (uint)denseToNode.size();
+		nodeToDense[node] = denseIndex;
+		denseToNode.push_back(node);
+
+		parents.push_back(parentNode != InvalidNode ? nodeToDense[parentNode] : InvalidNode);
+		positionX.push_back(0.0f); positionY.push_back(0.0f); positionZ.push_back(0.0f);
+		rotationX.push_back(0.0f); rotationY.push_back(0.0f); rotationZ.push_back(0.0f); rotationW.push_back(1.0f);
+		scaleX.push_back(1.0f); scaleY.push_back(1.0f); scaleZ.push_back(1.0f);
+		localMatrices.push_back(glm::mat4(1.0f));
+		worldMatrices.push_back(glm::mat4(1.0f));
+		worldRotations.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+		worldScales.push_back(glm::vec3(1.0f));
+		localDirty.push_back(1);
+		worldChanged.push_back(0);
+		alive.push_back(1);
+
+		//appending keeps the order valid only for roots, children need a rebuild to be placed after their parent level
+		orderDirty = true;
+		hasChanges = true;
+		return node;
+	}
+
+	void TransformHierarchy::destroyNode(uint node)
+	{
+		if (node >= nodeToDense.size() || nodeToDense[node] == InvalidNode) return;
+
+		//compacted on the next rebuild, children become roots
+		uint denseIndex = nodeToDense[node];
+		alive[denseIndex] = 0;
+		nodeToDense[node] = InvalidNode;
+		pendingFreeNodes.push_back(node);
+		orderDirty = true;
+		hasChanges = true;
+	}
+
+	void TransformHierarchy::setParent(uint node, uint parentNode)
+	{
+		uint denseIndex = nodeToDense[node];
+		uint parentIndex = parentNode != InvalidNode ? nodeToDense[parentNode] : InvalidNode;
+
+		//reject cycles
+		for (uint ancestor = parentIndex; ancestor != InvalidNode; ancestor = parents[ancestor]) {
+			if (ancestor == denseIndex) {
+				COMPHILOG_CORE_ERROR("TransformHierarchy: node {0} can't be parented to its own child!", node);
+				return;
+			}
+		}
+
+		parents[denseIndex] = parentIndex;
+		markDirty(denseIndex);
+		orderDirty = true;
+	}
+
+	uint TransformHierarchy::getParent(uint node) const
+	{
+		uint parentIndex = parents[nodeToDense[node]];
+		return parentIndex != InvalidNode ? denseToNode[parentIndex] : InvalidNode;
+	}
+
+	glm::vec3 TransformHierarchy::getPosition(uint node) const
+	{
+		uint i = nodeToDense[node];
+		return glm::vec3(positionX[i], positionY[i], positionZ[i]);
+	}
+
+	glm::quat TransformHierarchy::getRotation(uint node) const
+	{
+		uint i = nodeToDense[node];
+		return glm::quat(rotationW[i], rotationX[i], rotationY[i], rotationZ[i]);
+	}
+
+	glm::vec3 TransformHierarchy::getScale(uint node) const
+	{
+		uint i = nodeToDense[node];
+		return glm::vec3(scaleX[i], scaleY[i], scaleZ[i]);
+	}
+
+	void TransformHierarchy::setPosition(uint node, const glm::vec3& position)
+	{
+		uint i = nodeToDense[node];
+		positionX[i] = position.x; positionY[i] = position.y; positionZ[i] = position.z;
+		markDirty(i);
+	}
+
+	void TransformHierarchy::setRotation(uint node, const glm::quat& rotation)
+	{
+		uint i = nodeToDense[node];
+		rotationX[i] = rotation.x; rotationY[i] = rotation.y; rotationZ[i] = rotation.z; rotationW[i] = rotation.w;
+		markDirty(i);
+	}
+
+	void TransformHierarchy::setScale(uint node, const glm::vec3& scale)
+	{
+		uint i = nodeToDense[node];
+		scaleX[i] = scale.x; scaleY[i] = scale.y; scaleZ[i] = scale.z;
+		markDirty(i);
+	}
+
+	TRSArrays TransformHierarchy::getTRSArrays() const
+	{
+		return {
+			positionX.data(), positionY.data(), positionZ.data(),
+			rotationX.data(), rotationY.data(), rotationZ.data(), rotationW.data(),
+			scaleX.data(), scaleY.data(), scaleZ.data()
+		};
+	}
+
+	const glm::mat4& TransformHierarchy::getLocalMatrix(uint node)
+	{
+		update();
+		return localMatrices[nodeToDense[node]];
+	}
+
+	const glm::mat4& TransformHierarchy::getWorldMatrix(uint node)
+	{
+		update();
+		return worldMatrices[nodeToDense[node]];
+	}
+
+	const glm::quat& TransformHierarchy::getWorldRotation(uint node)
+	{
+		update();
+		return worldRotations[nodeToDense[node]];
+	}
+
+	const glm::vec3& TransformHierarchy::getWorldScale(uint node)
+	{
+		update();
+		return worldScales[nodeToDense[node]];
+	}
+
+	void TransformHierarchy::markDirty(uint denseIndex)
+	{
+		localDirty[denseIndex] = 1;
+		hasChanges = true;
+	}
+
+	void TransformHierarchy::update()
+	{
+		if (!hasChanges) return;
+		if (orderDirty) rebuildOrder();
+
+		//a level only reads the world matrices of the previous one
+		for (uint level = 0; level < getLevelCount(); level++)
+		{
+			ThreadPool::get()->parallelFor(levelOffsets[level], levelOffsets[level + 1], parallelBatchSize, [this](uint begin, uint end) {
+				updateRange(begin, end);
+			});
+		}
+
+		hasChanges = false;
+	}
+
+	void TransformHierarchy::updateRange(uint begin, uint end)
+	{
+		//local matrices of consecutive dirty nodes are composed in one SIMD batch
+		TRSArrays trs = getTRSArrays();
+		uint runBegin = begin;
+		for (uint i = begin; i <= end; i++)
+		{
+			if (i < end && localDirty[i]) continue;
+			if (i > runBegin) {
+				TransformKernels::composeTRS(trs.offset(runBegin), i - runBegin, &localMatrices[runBegin]);
+			}
+			runBegin = i + 1;
+		}
+
+		for (uint i = begin; i < end; i++)
+		{
+			uint parent = parents[i];
+			bool parentChanged = parent != InvalidNode && worldChanged[parent];
+
+			if (!localDirty[i] && !parentChanged) {
+				worldChanged[i] = 0;
+				continue;
+			}
+			localDirty[i] = 0;
+
+			glm::quat rotation = glm::quat(rotationW[i], rotationX[i], rotationY[i], rotationZ[i]);
+			glm::vec3 scale = glm::vec3(scaleX[i], scaleY[i], scaleZ[i]);
+			if (parent != InvalidNode) {
+				worldMatrices[i] = worldMatrices[parent] * localMatrices[i];
+				worldRotations[i] = worldRotations[parent] * rotation;
+				worldScales[i] = worldScales[parent] * scale;
+			}
+			else {
+				worldMatrices[i] = localMatrices[i];
+				worldRotations[i] = rotation;
+				worldScales[i] = scale;
+			}
+			worldChanged[i] = 1;
+		}
+	}
+
+	template<typename T>
+	static void applyOrder(std::vector<T>& data, const std::vector<uint>& order)
+	{
+		std::vector<T> ordered;
+		ordered.reserve(order.size());
+		for (uint oldIndex : order) {
+			ordered.push_back(data[oldIndex]);
+		}
+		data.swap(ordered);
+	}
+
+	void TransformHierarchy::rebuildOrder()
+	{
+		uint count = (uint)denseToNode.size();
+
+		//dead parents detach their children (they keep their local transform as world)
+		for (uint i = 0; i < count; i++)
+		{
+			if (parents[i] != InvalidNode && !alive[parents[i]]) {
+				parents[i] = InvalidNode;
+				localDirty[i] = 1;
+			}
+		}
+
+		//depth of every node, walking up until a known depth is found
+		std::vector<uint> depths(count, InvalidNode);
+		std::vector<uint> chain;
+		for (uint i = 0; i < count; i++)
+		{
+			uint current = i;
+			while (current != InvalidNode && depths[current] == InvalidNode) {
+				chain.push_back(current);
+				current = parents[current];
+			}
+			uint depth = current == InvalidNode ? 0 : depths[current] + 1;
+			for (auto it = chain.rbegin(); it != chain.rend(); it++) {
+				depths[*it] = depth++;
+			}
+			chain.clear();
+		}
+
+		std::vector<uint> order;
+		order.reserve(count);
+		for (uint i = 0; i < count; i++)
+		{
+			if (alive[i]) order.push_back(i);
+		}
+		std::stable_sort(order.begin(), order.end(), [&depths](uint a, uint b) { return depths[a] < depths[b]; });
+
+		std::vector<uint> oldToNew(count, InvalidNode);
+		for (uint newIndex = 0; newIndex < order.size(); newIndex++)
+		{
+			oldToNew[order[newIndex]] = newIndex;
+		}
+
+		applyOrder(parents, order);
+		applyOrder(positionX, order); applyOrder(positionY, order); applyOrder(positionZ, order);
+		applyOrder(rotationX, order); applyOrder(rotationY, order); applyOrder(rotationZ, order); applyOrder(rotationW, order);
+		applyOrder(scaleX, order); applyOrder(scaleY, order); applyOrder(scaleZ, order);
+		applyOrder(localMatrices, order);
+		applyOrder(worldMatrices, order);
+		applyOrder(worldRotations, order);
+		applyOrder(worldScales, order);
+		applyOrder(localDirty, order);
+		applyOrder(worldChanged, order);
+		applyOrder(alive, order);
+		applyOrder(denseToNode, order);
+
+		levelOffsets.clear();
+		for (uint newIndex = 0; newIndex < order.size(); newIndex++)
+		{
+			if (parents[newIndex] != InvalidNode) parents[newIndex] = oldToNew[parents[newIndex]];
+			nodeToDense[denseToNode[newIndex]] = newIndex;
+
+			uint depth = depths[order[newIndex]];
+			while (levelOffsets.size() <= depth) {
+				levelOffsets.push_back(newIndex);
+			}
+		}
+		levelOffsets.push_back((uint)order.size());
+
+		freeNodes.insert(freeNodes.end(), pendingFreeNodes.begin(), pendingFreeNodes.end());
+		pendingFreeNodes.clear();
+		orderDirty = false;
+	}
+
+}
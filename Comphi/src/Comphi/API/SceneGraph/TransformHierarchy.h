@@ -0,0 +1,75 @@
+#pragma once
+#include "TransformKernels.h"
+
+namespace Comphi {
+
+	//Flat transform hierarchy, nodes are stored in contiguous arrays sorted by depth
+	//(parents always before children) so world matrices are resolved level by level
+	//Node IDs are stable handles, dense indices change when the order is rebuilt
+	class TransformHierarchy
+	{
+	public:
+		static constexpr uint InvalidNode = UINT32_MAX;
+		static TransformHierarchy* get();
+
+		uint createNode(uint parentNode = InvalidNode);
+		void destroyNode(uint node);
+		void setParent(uint node, uint parentNode);
+		uint getParent(uint node) const;
+
+		//Local space
+		glm::vec3 getPosition(uint node) const;
+		glm::quat getRotation(uint node) const;
+		glm::vec3 getScale(uint node) const;
+		void setPosition(uint node, const glm::vec3& position);
+		void setRotation(uint node, const glm::quat& rotation);
+		void setScale(uint node, const glm::vec3& scale);
+
+		//World space, updates the hierarchy first if anything changed (not thread safe while changes are pending)
+		const glm::mat4& getLocalMatrix(uint node);
+		const glm::mat4& getWorldMatrix(uint node);
+		const glm::quat& getWorldRotation(uint node);
+		const glm::vec3& getWorldScale(uint node);
+
+		//Recomputes the changed world matrices, each depth level is split across the ThreadPool
+		void update();
+
+		inline uint getNodeCount() const { return (uint)denseToNode.size(); }
+		inline uint getLevelCount() const { return levelOffsets.empty() ? 0 : (uint)levelOffsets.size() - 1; }
+
+		//Levels with less nodes than this are computed on the calling thread
+		uint parallelBatchSize = 1024;
+
+	private:
+		void markDirty(uint denseIndex);
+		void rebuildOrder();
+		void updateRange(uint begin, uint end);
+
+		TRSArrays getTRSArrays() const;
+
+		//Dense arrays (sorted by depth after rebuildOrder)
+		std::vector<uint> parents; //dense index of the parent or InvalidNode
+		std::vector<float> positionX, positionY, positionZ; //local TRS as SoA for the TransformKernels
+		std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+		std::vector<float> scaleX, scaleY, scaleZ;
+		std::vector<glm::mat4> localMatrices;
+		std::vector<glm::mat4> worldMatrices;
+		std::vector<glm::quat> worldRotations;
+		std::vector<glm::vec3> worldScales;
+		std::vector<uint8_t> localDirty;
+		std::vector<uint8_t> worldChanged;
+		std::vector<uint8_t> alive;
+		std::vector<uint> denseToNode;
+
+		std::vector<uint> levelOffsets; //level N = [levelOffsets[N], levelOffsets[N+1])
+
+		//Sparse node -> dense index
+		std::vector<uint> nodeToDense;
+		std::vector<uint> freeNodes;
+		std::vector<uint> pendingFreeNodes; //released on the next rebuildOrder
+
+		bool orderDirty = false;
+		bool hasChanges = false;
+	};
+
+}
@@ -0,0 +1,252 @@
+#include "cphipch.h"
+#include "TransformKernels.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+	#define CPHI_X64_SIMD
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define CPHI_TARGET_AVX2
+	#else
+		#include <cpuid.h>
+		#define CPHI_TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#endif
+
+namespace Comphi {
+
+	//Rotation matrix columns from a quaternion (same layout as glm::toMat4) scaled per axis
+	static inline void composeTRSSingle(const TRSArrays& trs, uint i, glm::mat4& out)
+	{
+		float qx = trs.rotationX[i], qy = trs.rotationY[i], qz = trs.rotationZ[i], qw = trs.rotationW[i];
+		float xx = qx * qx, yy = qy * qy, zz = qz * qz;
+		float xy = qx * qy, xz = qx * qz, yz = qy * qz;
+		float wx = qw * qx, wy = qw * qy, wz = qw * qz;
+		float sx = trs.scaleX[i], sy = trs.scaleY[i], sz = trs.scaleZ[i];
+
+		out[0] = glm::vec4((1.0f - 2.0f * (yy + zz)) * sx, 2.0f * (xy + wz) * sx, 2.0f * (xz - wy) * sx, 0.0f);
+		out[1] = glm::vec4(2.0f * (xy - wz) * sy, (1.0f - 2.0f * (xx + zz)) * sy, 2.0f * (yz + wx) * sy, 0.0f);
+		out[2] = glm::vec4(2.0f * (xz + wy) * sz, 2.0f * (yz - wx) * sz, (1.0f - 2.0f * (xx + yy)) * sz, 0.0f);
+		out[3] = glm::vec4(trs.positionX[i], trs.positionY[i], trs.positionZ[i], 1.0f);
+	}
+
+	void TransformKernels::composeTRSScalar(const TRSArrays& trs, uint count, glm::mat4* outMatrices)
+	{
+		for (uint i = 0; i < count; i++)
+		{
+			composeTRSSingle(trs, i, outMatrices[i]);
+		}
+	}
+
+#ifdef CPHI_X64_SIMD
+
+	void TransformKernels::composeTRSSSE(const TRSArrays& trs, uint count, glm::mat4* outMatrices)
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+		const __m128 zero = _mm_setzero_ps();
+
+		uint i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 qx = _mm_loadu_ps(trs.rotationX + i);
+			__m128 qy = _mm_loadu_ps(trs.rotationY + i);
+			__m128 qz = _mm_loadu_ps(trs.rotationZ + i);
+			__m128 qw = _mm_loadu_ps(trs.rotationW + i);
+			__m128 sx = _mm_loadu_ps(trs.scaleX + i);
+			__m128 sy = _mm_loadu_ps(trs.scaleY + i);
+			__m128 sz = _mm_loadu_ps(trs.scaleZ + i);
+
+			__m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+			__m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+			__m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+
+			//one register per matrix element, one lane per transform
+			__m128 c0x = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+			__m128 c0y = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+			__m128 c0z = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+			__m128 c0w = zero;
+
+			__m128 c1x = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+			__m128 c1y = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+			__m128 c1z = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+			__m128 c1w = zero;
+
+			__m128 c2x = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+			__m128 c2y = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+			__m128 c2z = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+			__m128 c2w = zero;
+
+			__m128 c3x = _mm_loadu_ps(trs.positionX + i);
+			__m128 c3y = _mm_loadu_ps(trs.positionY + i);
+			__m128 c3z = _mm_loadu_ps(trs.positionZ + i);
+			__m128 c3w = one;
+
+			//lanes -> per transform columns
+			_MM_TRANSPOSE4_PS(c0x, c0y, c0z, c0w);
+			_MM_TRANSPOSE4_PS(c1x, c1y, c1z, c1w);
+			_MM_TRANSPOSE4_PS(c2x, c2y, c2z, c2w);
+			_MM_TRANSPOSE4_PS(c3x, c3y, c3z, c3w);
+
+			float* out = &outMatrices[i][0][0];
+			_mm_storeu_ps(out + 0, c0x);  _mm_storeu_ps(out + 4, c1x);  _mm_storeu_ps(out + 8, c2x);  _mm_storeu_ps(out + 12, c3x);
+			_mm_storeu_ps(out + 16, c0y); _mm_storeu_ps(out + 20, c1y); _mm_storeu_ps(out + 24, c2y); _mm_storeu_ps(out + 28, c3y);
+			_mm_storeu_ps(out + 32, c0z); _mm_storeu_ps(out + 36, c1z); _mm_storeu_ps(out + 40, c2z); _mm_storeu_ps(out + 44, c3z);
+			_mm_storeu_ps(out + 48, c0w); _mm_storeu_ps(out + 52, c1w); _mm_storeu_ps(out + 56, c2w); _mm_storeu_ps(out + 60, c3w);
+		}
+
+		composeTRSScalar(trs.offset(i), count - i, outMatrices + i);
+	}
+
+	//4x4 transpose inside each 128bit half : x,y,z,w of 8 transforms -> columns of transforms (k | k+4)
+	CPHI_TARGET_AVX2 static inline void transposeHalves(__m256 x, __m256 y, __m256 z, __m256 w, __m256 out[4])
+	{
+		__m256 t0 = _mm256_unpacklo_ps(x, y);
+		__m256 t1 = _mm256_unpackhi_ps(x, y);
+		__m256 t2 = _mm256_unpacklo_ps(z, w);
+		__m256 t3 = _mm256_unpackhi_ps(z, w);
+		out[0] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+		out[1] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+		out[2] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+		out[3] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+	}
+
+	CPHI_TARGET_AVX2 void TransformKernels::composeTRSAVX2(const TRSArrays& trs, uint count, glm::mat4* outMatrices)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 two = _mm256_set1_ps(2.0f);
+		const __m256 zero = _mm256_setzero_ps();
+
+		uint i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 qx = _mm256_loadu_ps(trs.rotationX + i);
+			__m256 qy = _mm256_loadu_ps(trs.rotationY + i);
+			__m256 qz = _mm256_loadu_ps(trs.rotationZ + i);
+			__m256 qw = _mm256_loadu_ps(trs.rotationW + i);
+			__m256 sx = _mm256_loadu_ps(trs.scaleX + i);
+			__m256 sy = _mm256_loadu_ps(trs.scaleY + i);
+			__m256 sz = _mm256_loadu_ps(trs.scaleZ + i);
+
+			__m256 xx = _mm256_mul_ps(qx, qx), yy = _mm256_mul_ps(qy, qy), zz = _mm256_mul_ps(qz, qz);
+			__m256 xy = _mm256_mul_ps(qx, qy), xz = _mm256_mul_ps(qx, qz), yz = _mm256_mul_ps(qy, qz);
+			__m256 wx = _mm256_mul_ps(qw, qx), wy = _mm256_mul_ps(qw, qy), wz = _mm256_mul_ps(qw, qz);
+
+			__m256 columns[4][4];
+			transposeHalves(
+				_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx),
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx),
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx),
+				zero, columns[0]);
+			transposeHalves(
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy),
+				_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy),
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy),
+				zero, columns[1]);
+			transposeHalves(
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz),
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz),
+				_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz),
+				zero, columns[2]);
+			transposeHalves(
+				_mm256_loadu_ps(trs.positionX + i),
+				_mm256_loadu_ps(trs.positionY + i),
+				_mm256_loadu_ps(trs.positionZ + i),
+				one, columns[3]);
+
+			//columns 0|1 and 2|3 of a transform are contiguous, store them 32 bytes at a time
+			for (uint k = 0; k < 4; k++)
+			{
+				float* outA = &outMatrices[i + k][0][0];
+				float* outB = &outMatrices[i + k + 4][0][0];
+				_mm256_storeu_ps(outA + 0, _mm256_permute2f128_ps(columns[0][k], columns[1][k], 0x20));
+				_mm256_storeu_ps(outA + 8, _mm256_permute2f128_ps(columns[2][k], columns[3][k], 0x20));
+				_mm256_storeu_ps(outB + 0, _mm256_permute2f128_ps(columns[0][k], columns[1][k], 0x31));
+				_mm256_storeu_ps(outB + 8, _mm256_permute2f128_ps(columns[2][k], columns[3][k], 0x31));
+			}
+		}
+		_mm256_zeroupper();
+
+		composeTRSScalar(trs.offset(i), count - i, outMatrices + i);
+	}
+
+	static bool isAVX2Supported()
+	{
+		int info[4] = {};
+#ifdef _MSC_VER
+		__cpuid(info, 0);
+		if (info[0] < 7) return false;
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx) return false;
+		//OS saves YMM registers on context switch
+		if ((_xgetbv(0) & 0x6) != 0x6) return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		unsigned int a, b, c, d;
+		if (!__get_cpuid(1, &a, &b, &c, &d)) return false;
+		if (!(c & (1 << 27)) || !(c & (1 << 28))) return false;
+		unsigned int xcr0Low, xcr0High;
+		__asm__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+		if ((xcr0Low & 0x6) != 0x6) return false;
+		if (!__get_cpuid_count(7, 0, &a, &b, &c, &d)) return false;
+		(void)info;
+		return (b & (1 << 5)) != 0;
+#endif
+	}
+
+	TransformKernels::SIMDLevel TransformKernels::getSupportedSIMDLevel()
+	{
+		//SSE2 is part of x64
+		static const SIMDLevel level = isAVX2Supported() ? AVX2 : SSE;
+		return level;
+	}
+
+#else
+
+	void TransformKernels::composeTRSSSE(const TRSArrays& trs, uint count, glm::mat4* outMatrices)
+	{
+		composeTRSScalar(trs, count, outMatrices);
+	}
+
+	void TransformKernels::composeTRSAVX2(const TRSArrays& trs, uint count, glm::mat4* outMatrices)
+	{
+		composeTRSScalar(trs, count, outMatrices);
+	}
+
+	TransformKernels::SIMDLevel TransformKernels::getSupportedSIMDLevel()
+	{
+		return Scalar;
+	}
+
+#endif
+
+	const char* TransformKernels::getSIMDLevelName(SIMDLevel level)
+	{
+		switch (level)
+		{
+		case AVX2: return "AVX2";
+		case SSE: return "SSE";
+		default: return "Scalar";
+		}
+	}
+
+	void TransformKernels::composeTRS(const TRSArrays& trs, uint count, glm::mat4* outMatrices)
+	{
+		switch (getSupportedSIMDLevel())
+		{
+		case AVX2:
+			composeTRSAVX2(trs, count, outMatrices);
+			break;
+		case SSE:
+			composeTRSSSE(trs, count, outMatrices);
+			break;
+		default:
+			composeTRSScalar(trs, count, outMatrices);
+			break;
+		}
+	}
+
+}
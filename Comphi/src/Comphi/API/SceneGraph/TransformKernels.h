@@ -0,0 +1,51 @@
+#pragma once
+
+namespace Comphi {
+
+	//SoA inputs of a batch of transforms (one float array per component)
+	struct TRSArrays {
+		const float* positionX;
+		const float* positionY;
+		const float* positionZ;
+		const float* rotationX;
+		const float* rotationY;
+		const float* rotationZ;
+		const float* rotationW;
+		const float* scaleX;
+		const float* scaleY;
+		const float* scaleZ;
+
+		//offsets every array by first
+		TRSArrays offset(uint first) const {
+			return {
+				positionX + first, positionY + first, positionZ + first,
+				rotationX + first, rotationY + first, rotationZ + first, rotationW + first,
+				scaleX + first, scaleY + first, scaleZ + first
+			};
+		}
+	};
+
+	//Fused Translate * Rotate * Scale composition into model matrices
+	//Same result as glm::translate(p) * glm::toMat4(q) * glm::scale(s)
+	class TransformKernels
+	{
+	public:
+		enum SIMDLevel {
+			Scalar,
+			SSE,	//4 transforms per iteration
+			AVX2	//8 transforms per iteration
+		};
+
+		//best level supported by the CPU, detected once at runtime
+		static SIMDLevel getSupportedSIMDLevel();
+		static const char* getSIMDLevelName(SIMDLevel level);
+
+		//dispatches to the best supported kernel
+		static void composeTRS(const TRSArrays& trs, uint count, glm::mat4* outMatrices);
+
+		static void composeTRSScalar(const TRSArrays& trs, uint count, glm::mat4* outMatrices);
+		static void composeTRSSSE(const TRSArrays& trs, uint count, glm::mat4* outMatrices);
+		static void composeTRSAVX2(const TRSArrays& trs, uint count, glm::mat4* outMatrices);
+	};
+
+}
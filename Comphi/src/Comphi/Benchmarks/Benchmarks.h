@@ -0,0 +1,16 @@
+#pragma once
+#include "Comphi/API/Rendering/Material.h"
+
+namespace Comphi::Benchmarks {
+
+	//Logs old (dynamic_cast scan) vs new (type ID slot table) component lookup cost
+	void ComponentLookup(uint entityCount = 10000);
+
+	//Logs glm translate/rotate/scale vs the TransformKernels batch composition at 1k, 10k and 100k transforms
+	void TransformCompose();
+
+	//Logs pipeline creation from an empty VkPipelineCache (cold start) vs one created from serialized cache data (warm start)
+	//Requires an initialized graphics context, material is recompiled pipelineCount times
+	void PipelineCacheStartup(MaterialPtr material, uint pipelineCount = 32);
+
+}
@@ -0,0 +1,81 @@
+#include "cphipch.h"
+#include "Benchmarks.h"
+#include "Comphi/Utils/Benchmark.h"
+#include "Comphi/API/SceneGraph/Entity.h"
+#include "Comphi/API/Components/Transform.h"
+#include "Comphi/API/Components/Camera.h"
+#include "Comphi/API/Components/Renderer.h"
+
+namespace Comphi::Benchmarks {
+
+	//Component storage before the ECS: vector of components + dynamic_cast scan
+	struct LegacyEntity {
+		std::vector<ComponentPtr> componentList;
+
+		template<typename T>
+		std::shared_ptr<T> GetComponent() {
+			for (size_t i = 0; i < componentList.size(); i++)
+			{
+				T* componentPtr = dynamic_cast<T*>(componentList[i].get());
+				if (componentPtr != nullptr) {
+					return (std::static_pointer_cast<T>(componentList[i]));
+				}
+			}
+			return nullptr;
+		}
+	};
+
+	void ComponentLookup(uint entityCount)
+	{
+		static MeshObjectPtr meshObject;
+		static MaterialInstancePtr materialInstance;
+
+		std::vector<LegacyEntity> legacyEntities(entityCount);
+		std::vector<EntityPtr> entities(entityCount);
+		for (uint i = 0; i < entityCount; i++)
+		{
+			legacyEntities[i].componentList.push_back(std::make_shared<Transform>());
+			legacyEntities[i].componentList.push_back(std::make_shared<Renderer>(meshObject, materialInstance));
+
+			entities[i] = std::make_shared<Entity>();
+			entities[i]->AddComponent(std::make_shared<Transform>());
+			entities[i]->AddComponent(std::make_shared<Renderer>(meshObject, materialInstance));
+		}
+
+		//Same lookups as SceneGraph::addEntity : Transform (hit), Camera (miss), Renderer (hit)
+		COMPHILOG_CORE_INFO("[Benchmark] Component lookup, {0} entities x 3 lookups", entityCount);
+
+		double legacy = Benchmark::run("GetComponent dynamic_cast scan", entityCount * 3, [&](uint) {
+			uint64 found = 0;
+			for (auto& entity : legacyEntities) {
+				found += entity.GetComponent<Transform>() != nullptr;
+				found += entity.GetComponent<Camera>() != nullptr;
+				found += entity.GetComponent<Renderer>() != nullptr;
+			}
+			return found;
+		});
+
+		double typeID = Benchmark::run("GetComponent type ID slot table", entityCount * 3, [&](uint) {
+			uint64 found = 0;
+			for (auto& entity : entities) {
+				found += entity->GetComponent<Transform>() != nullptr;
+				found += entity->GetComponent<Camera>() != nullptr;
+				found += entity->GetComponent<Renderer>() != nullptr;
+			}
+			return found;
+		});
+
+		double mask = Benchmark::run("HasComponent mask test", entityCount * 3, [&](uint) {
+			uint64 found = 0;
+			for (auto& entity : entities) {
+				found += entity->HasComponent<Transform>();
+				found += entity->HasComponent<Camera>();
+				found += entity->HasComponent<Renderer>();
+			}
+			return found;
+		});
+
+		COMPHILOG_CORE_INFO("[Benchmark] Component lookup speedup: GetComponent x{0:.2f}, HasComponent x{1:.2f}", legacy / typeID, legacy / mask);
+	}
+
+}
@@ -0,0 +1,59 @@
+#include "cphipch.h"
+#include "Benchmarks.h"
+#include "Comphi/Utils/Benchmark.h"
+#include "Comphi/Renderer/Vulkan/Graphics/GraphicsPipeline.h"
+#include "Comphi/Renderer/Vulkan/Graphics/PipelineCache.h"
+
+namespace Comphi::Benchmarks {
+
+	static void compilePipeline(const GraphicsPipelineConfiguration& configuration, Vulkan::PipelineCache& cache)
+	{
+		//background compiles keep using the shared cache
+		Vulkan::GraphicsPipeline pipeline;
+		pipeline.configuration = configuration;
+		pipeline.pipelineCache = cache.cacheObj;
+		pipeline.initialize();
+		pipeline.cleanUp();
+	}
+
+	//Every pipeline gets its own cache made from initialData, like a fresh launch would
+	static uint compilePipelines(const GraphicsPipelineConfiguration& configuration, const std::vector<char>& initialData, uint pipelineCount)
+	{
+		for (uint i = 0; i < pipelineCount; i++)
+		{
+			Vulkan::PipelineCache cache(initialData);
+			compilePipeline(configuration, cache);
+			cache.cleanUp();
+		}
+		return pipelineCount;
+	}
+
+	void PipelineCacheStartup(MaterialPtr material, uint pipelineCount)
+	{
+		material->waitUntilReady();
+		const GraphicsPipelineConfiguration& configuration = material->configuration;
+
+		//warm data: what the previous launch would have saved to disk
+		std::vector<char> warmData;
+		{
+			Vulkan::PipelineCache cache(std::vector<char>{});
+			compilePipeline(configuration, cache);
+			warmData = cache.getData();
+			cache.cleanUp();
+		}
+
+		//NOTE: drivers with their own shader disk cache hide part of the cold cost
+		COMPHILOG_CORE_INFO("[Benchmark] Pipeline cache startup, {0} pipelines ({1} bytes of cache data)", pipelineCount, warmData.size());
+
+		double cold = Benchmark::run("vkCreateGraphicsPipelines empty cache", pipelineCount, [&](uint iterations) {
+			return compilePipelines(configuration, {}, iterations);
+		}, 3);
+
+		double warm = Benchmark::run("vkCreateGraphicsPipelines loaded cache", pipelineCount, [&](uint iterations) {
+			return compilePipelines(configuration, warmData, iterations);
+		}, 3);
+
+		COMPHILOG_CORE_INFO("[Benchmark] Pipeline cache startup: cold {0:.2f} ms, warm {1:.2f} ms, speedup x{2:.2f}", cold * pipelineCount / 1e6, warm * pipelineCount / 1e6, cold / warm);
+	}
+
+}
@@ -0,0 +1,84 @@
+#include "cphipch.h"
+#include "Benchmarks.h"
+#include "Comphi/Utils/Benchmark.h"
+#include "Comphi/API/SceneGraph/TransformKernels.h"
+#include <random>
+
+namespace Comphi::Benchmarks {
+
+	//the float's bits (casting a negative float to an unsigned integer is undefined)
+	static inline uint64 sinkValue(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	static void TransformCompose(uint count)
+	{
+		std::mt19937 random(count);
+		std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+		std::vector<glm::vec3> positions(count), scales(count);
+		std::vector<glm::quat> rotations(count);
+		std::vector<float> soa[10];
+		for (auto& array : soa) array.resize(count);
+
+		for (uint i = 0; i < count; i++)
+		{
+			positions[i] = glm::vec3(distribution(random), distribution(random), distribution(random)) * 100.0f;
+			rotations[i] = glm::normalize(glm::quat(distribution(random), distribution(random), distribution(random), distribution(random)));
+			scales[i] = glm::vec3(1.0f + distribution(random) * 0.5f);
+
+			soa[0][i] = positions[i].x; soa[1][i] = positions[i].y; soa[2][i] = positions[i].z;
+			soa[3][i] = rotations[i].x; soa[4][i] = rotations[i].y; soa[5][i] = rotations[i].z; soa[6][i] = rotations[i].w;
+			soa[7][i] = scales[i].x; soa[8][i] = scales[i].y; soa[9][i] = scales[i].z;
+		}
+		TRSArrays trs = {
+			soa[0].data(), soa[1].data(), soa[2].data(),
+			soa[3].data(), soa[4].data(), soa[5].data(), soa[6].data(),
+			soa[7].data(), soa[8].data(), soa[9].data()
+		};
+
+		std::vector<glm::mat4> matrices(count);
+		COMPHILOG_CORE_INFO("[Benchmark] TRS composition, {0} transforms", count);
+
+		double glmPath = Benchmark::run("glm translate * toMat4 * scale", count, [&](uint) {
+			for (uint i = 0; i < count; i++)
+			{
+				glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), positions[i]);
+				modelMatrix *= glm::toMat4(rotations[i]);
+				matrices[i] = glm::scale(modelMatrix, scales[i]);
+			}
+			return sinkValue(matrices[count - 1][3][0]);
+		});
+
+		auto runKernel = [&](const char* name, void(*kernel)(const TRSArrays&, uint, glm::mat4*)) {
+			return Benchmark::run(name, count, [&](uint) {
+				kernel(trs, count, matrices.data());
+				return sinkValue(matrices[count - 1][3][0]);
+			});
+		};
+
+		double scalar = runKernel("TransformKernels Scalar", TransformKernels::composeTRSScalar);
+		COMPHILOG_CORE_INFO("[Benchmark] speedup vs glm: Scalar x{0:.2f}", glmPath / scalar);
+
+		if (TransformKernels::getSupportedSIMDLevel() >= TransformKernels::SSE) {
+			double sse = runKernel("TransformKernels SSE", TransformKernels::composeTRSSSE);
+			COMPHILOG_CORE_INFO("[Benchmark] speedup vs glm: SSE x{0:.2f}", glmPath / sse);
+		}
+		if (TransformKernels::getSupportedSIMDLevel() >= TransformKernels::AVX2) {
+			double avx2 = runKernel("TransformKernels AVX2", TransformKernels::composeTRSAVX2);
+			COMPHILOG_CORE_INFO("[Benchmark] speedup vs glm: AVX2 x{0:.2f}", glmPath / avx2);
+		}
+	}
+
+	void TransformCompose()
+	{
+		COMPHILOG_CORE_INFO("[Benchmark] TransformKernels SIMD level: {0}", TransformKernels::getSIMDLevelName(TransformKernels::getSupportedSIMDLevel()));
+		for (uint count : { 1000u, 10000u, 100000u }) {
+			TransformCompose(count);
+		}
+	}
+
+}
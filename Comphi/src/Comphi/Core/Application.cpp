@@ -41,6 +41,9 @@ namespace Comphi {
 			for (auto layer : m_LayerStack) {
 				layer->OnUpdate();
 			}
+
+			//Transform Loop
+			TransformHierarchy::get()->update();
 			
 			//UI Render Loop
 			//m_ImGuiLayer->Begin();
@@ -0,0 +1,128 @@
+#include "cphipch.h"
+#include "ThreadPool.h"
+
+namespace Comphi {
+
+	static thread_local uint threadIndex = 0;
+
+	ThreadPool* ThreadPool::get()
+	{
+		static ThreadPool threadPool;
+		return &threadPool;
+	}
+
+	uint ThreadPool::getThreadIndex()
+	{
+		return threadIndex;
+	}
+
+	ThreadPool::ThreadPool(uint threadCount)
+	{
+		workers.reserve(threadCount);
+		for (uint i = 0; i < threadCount; i++)
+		{
+			workers.emplace_back(&ThreadPool::workerLoop, this, i + 1);
+		}
+		COMPHILOG_CORE_INFO("ThreadPool started with {0} worker threads", threadCount);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(jobsMutex);
+			stopping = true;
+		}
+		jobsCondition.notify_all();
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	}
+
+	void ThreadPool::enqueue(std::function<void()> job, bool background)
+	{
+		{
+			std::lock_guard<std::mutex> lock(jobsMutex);
+			if (background) backgroundJobs.push(std::move(job));
+			else jobs.push(std::move(job));
+		}
+		jobsCondition.notify_one();
+	}
+
+	bool ThreadPool::runPendingJob()
+	{
+		std::function<void()> job;
+		{
+			std::lock_guard<std::mutex> lock(jobsMutex);
+			if (jobs.empty()) return false;
+			job = std::move(jobs.front());
+			jobs.pop();
+		}
+		job();
+		return true;
+	}
+
+	void ThreadPool::workerLoop(uint index)
+	{
+		threadIndex = index;
+		while (true) {
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(jobsMutex);
+				jobsCondition.wait(lock, [this]() { return stopping || !jobs.empty() || !backgroundJobs.empty(); });
+				if (stopping && jobs.empty() && backgroundJobs.empty()) return;
+				std::queue<std::function<void()>>& queue = !jobs.empty() ? jobs : backgroundJobs;
+				job = std::move(queue.front());
+				queue.pop();
+			}
+			job();
+		}
+	}
+
+	void ThreadPool::parallelFor(uint begin, uint end, uint minBatchSize, const std::function<void(uint, uint)>& fn)
+	{
+		if (end <= begin) return;
+
+		uint count = end - begin;
+		uint batchCount = (std::min)(getThreadCount() + 1, (count + minBatchSize - 1) / (std::max)(1u, minBatchSize));
+		if (batchCount <= 1) {
+			fn(begin, end);
+			return;
+		}
+
+		uint batchSize = (count + batchCount - 1) / batchCount;
+		std::atomic<uint> remaining = batchCount - 1;
+
+		//exceptions can't leave a worker (std::terminate) : the first one is kept for the calling thread
+		std::exception_ptr exception;
+		std::mutex exceptionMutex;
+		auto runBatch = [&fn, &exception, &exceptionMutex](uint batchBegin, uint batchEnd) {
+			try {
+				if (batchBegin < batchEnd) fn(batchBegin, batchEnd);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(exceptionMutex);
+				if (!exception) exception = std::current_exception();
+			}
+		};
+
+		for (uint batch = 1; batch < batchCount; batch++)
+		{
+			uint batchBegin = begin + batch * batchSize;
+			uint batchEnd = (std::min)(end, batchBegin + batchSize);
+			enqueue([&runBatch, &remaining, batchBegin, batchEnd]() {
+				runBatch(batchBegin, batchEnd);
+				remaining.fetch_sub(1, std::memory_order_release);
+			});
+		}
+
+		runBatch(begin, (std::min)(end, begin + batchSize));
+
+		//help with the queue instead of blocking while batches are in flight
+		while (remaining.load(std::memory_order_acquire) != 0) {
+			if (!runPendingJob()) std::this_thread::yield();
+		}
+
+		if (exception) std::rethrow_exception(exception);
+	}
+
+}
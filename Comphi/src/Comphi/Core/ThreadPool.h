@@ -0,0 +1,71 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <atomic>
+#include <queue>
+
+namespace Comphi {
+
+	//Fixed set of worker threads shared by the engine (transforms, command recording, loading...)
+	class ThreadPool
+	{
+	public:
+		ThreadPool(uint threadCount = (std::max)(2u, std::thread::hardware_concurrency()) - 1);
+		~ThreadPool();
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		static ThreadPool* get();
+
+		inline uint getThreadCount() const { return (uint)workers.size(); }
+		//0 for the calling (main) thread, 1..N for workers
+		static uint getThreadIndex();
+
+		template<typename Fn>
+		auto submit(Fn&& fn) -> std::future<decltype(fn())>;
+
+		//Long running jobs (pipeline compilation, loading...), only picked up by workers when no regular job is queued
+		//so parallelFor callers never end up helping with them
+		template<typename Fn>
+		auto submitBackground(Fn&& fn) -> std::future<decltype(fn())>;
+
+		//Splits [begin, end) in batches of at least minBatchSize and calls fn(batchBegin, batchEnd)
+		//The calling thread works on batches too and returns once all of them are done
+		//the first exception thrown by fn is rethrown on the calling thread after every batch finished
+		void parallelFor(uint begin, uint end, uint minBatchSize, const std::function<void(uint, uint)>& fn);
+
+	private:
+		void enqueue(std::function<void()> job, bool background = false);
+		bool runPendingJob();
+		void workerLoop(uint threadIndex);
+
+		std::vector<std::thread> workers;
+		std::queue<std::function<void()>> jobs;
+		std::queue<std::function<void()>> backgroundJobs;
+		std::mutex jobsMutex;
+		std::condition_variable jobsCondition;
+		bool stopping = false;
+	};
+
+	template<typename Fn>
+	auto ThreadPool::submit(Fn&& fn) -> std::future<decltype(fn())>
+	{
+		typedef decltype(fn()) Result;
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Fn>(fn));
+		std::future<Result> result = task->get_future();
+		enqueue([task]() { (*task)(); });
+		return result;
+	}
+
+	template<typename Fn>
+	auto ThreadPool::submitBackground(Fn&& fn) -> std::future<decltype(fn())>
+	{
+		typedef decltype(fn()) Result;
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Fn>(fn));
+		std::future<Result> result = task->get_future();
+		enqueue([task]() { (*task)(); }, true);
+		return result;
+	}
+
+}
@@ -0,0 +1,133 @@
+#include "cphipch.h"
+#include "IGraphicsPipeline.h"
+
+namespace Comphi {
+
+	//fields are appended one by one (struct padding is never part of the key)
+	template<typename T>
+	static inline void appendKey(std::string& key, const T& value) {
+		static_assert(std::is_trivially_copyable_v<T>);
+		key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	static inline void appendKey(std::string& key, const std::string& value) {
+		appendKey(key, value.size());
+		key.append(value);
+	}
+
+	std::string GraphicsPipelineConfiguration::getCanonicalKey() const
+	{
+		std::string key;
+		appendKey(key, assemblySettings.topologyType);
+		appendKey(key, rasterizerSettings.polygonRenderMode);
+		appendKey(key, rasterizerSettings.lineWidth);
+		appendKey(key, rasterizerSettings.cullMode);
+		appendKey(key, rasterizerSettings.frontFace);
+		appendKey(key, rasterizerSettings.blendingMode);
+
+		//Vertex input (bindings & attributes are matched by ID, not by declaration order)
+		auto bindings = vertexInputLayoutConfiguration.vertexBufferBindingDescriptors;
+		std::sort(bindings.begin(), bindings.end(), [](const auto& a, const auto& b) { return a.bufferBindingID < b.bufferBindingID; });
+		appendKey(key, bindings.size());
+		for (const auto& binding : bindings) {
+			appendKey(key, binding.bufferBindingID);
+			appendKey(key, binding.vertexStride);
+			appendKey(key, binding.inputRate);
+		}
+
+		auto attributes = vertexInputLayoutConfiguration.vertexAttributeFormatDescriptors;
+		std::sort(attributes.begin(), attributes.end(), [](const auto& a, const auto& b) { return a.shaderLocationID < b.shaderLocationID; });
+		appendKey(key, attributes.size());
+		for (const auto& attribute : attributes) {
+			appendKey(key, attribute.shaderLocationID);
+			appendKey(key, attribute.bufferBindingID);
+			appendKey(key, attribute.format);
+			appendKey(key, attribute.offset);
+		}
+
+		//Layout (set & binding IDs are positions, order matters)
+		appendKey(key, pipelineLayoutConfiguration.layoutSets.size());
+		for (const auto& layoutSet : pipelineLayoutConfiguration.layoutSets) {
+			appendKey(key, layoutSet.shaderResourceDescriptorSetBindings.size());
+			for (const auto& binding : layoutSet.shaderResourceDescriptorSetBindings) {
+				appendKey(key, binding.resourceCount);
+				appendKey(key, binding.resourceType);
+				appendKey(key, binding.shaderStage);
+			}
+		}
+
+		auto pushConstantRanges = pipelineLayoutConfiguration.pushConstantRanges;
+		std::sort(pushConstantRanges.begin(), pushConstantRanges.end(), [](const auto& a, const auto& b) { return a.offset < b.offset; });
+		appendKey(key, pushConstantRanges.size());
+		for (const auto& range : pushConstantRanges) {
+			appendKey(key, range.shaderStage);
+			appendKey(key, range.offset);
+			appendKey(key, range.size);
+		}
+
+		//Shader stages (by source file & SPIR-V hash, modules loaded twice from one file are the same stage)
+		auto shaderPrograms = pipelineLayoutConfiguration.shaderPrograms;
+		std::sort(shaderPrograms.begin(), shaderPrograms.end(), [](IShaderProgram* a, IShaderProgram* b) { return a->GetType() < b->GetType(); });
+		appendKey(key, shaderPrograms.size());
+		for (const auto& shaderProgram : shaderPrograms) {
+			appendKey(key, shaderProgram->GetType());
+			appendKey(key, shaderProgram->shaderFile.getFilePath());
+			appendKey(key, shaderProgram->byteCodeSize);
+			appendKey(key, shaderProgram->byteCodeHash);
+			appendKey(key, shaderProgram->entryPointFunctionName);
+
+			//every variant is its own pipeline
+			SpecializationConstantMap constants = getSpecializationConstants(shaderProgram);
+			appendKey(key, constants.size());
+			for (const auto& [constantID, value] : constants) {
+				appendKey(key, constantID);
+				appendKey(key, value.index());
+				std::visit([&key](auto typedValue) { appendKey(key, typedValue); }, value);
+			}
+		}
+
+		return key;
+	}
+
+	uint64_t GraphicsPipelineConfiguration::getHash() const
+	{
+		return std::hash<std::string>()(getCanonicalKey());
+	}
+
+	std::vector<PushConstantRange> PipelineLayoutConfiguration::getLayoutPushConstantRanges() const
+	{
+		std::vector<PushConstantRange> layoutRanges;
+		for (uint stageBit = 1; stageBit != 0 && stageBit <= (uint)AllStages; stageBit <<= 1) {
+			uint begin = UINT32_MAX;
+			uint end = 0;
+			for (const auto& range : pushConstantRanges) {
+				if (((uint)range.shaderStage & stageBit) == 0 || range.size == 0) continue;
+				begin = (std::min)(begin, range.offset);
+				end = (std::max)(end, range.offset + range.size);
+			}
+			if (begin >= end) continue;
+
+			auto sameSpan = std::find_if(layoutRanges.begin(), layoutRanges.end(), [&](const PushConstantRange& range) { return range.offset == begin && range.offset + range.size == end; });
+			if (sameSpan != layoutRanges.end()) {
+				sameSpan->shaderStage = (ShaderStageFlag)((uint)sameSpan->shaderStage | stageBit);
+				continue;
+			}
+			layoutRanges.push_back({ (ShaderStageFlag)stageBit, begin, end - begin });
+		}
+		std::sort(layoutRanges.begin(), layoutRanges.end(), [](const auto& a, const auto& b) { return a.offset < b.offset; });
+		return layoutRanges;
+	}
+
+	SpecializationConstantMap GraphicsPipelineConfiguration::getSpecializationConstants(const IShaderProgram* shaderProgram) const
+	{
+		SpecializationConstantMap constants = shaderProgram->specializationConstants;
+		auto stageConstants = specializationConstants.find((ShaderType)shaderProgram->GetType());
+		if (stageConstants != specializationConstants.end()) {
+			for (const auto& [constantID, value] : stageConstants->second) {
+				constants[constantID] = value;
+			}
+		}
+		return constants;
+	}
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "Comphi/Renderer/IShaderProgram.h"
 #include "Comphi/Renderer/IUniformBuffer.h"
+#include <future>
 
 namespace Comphi {
 
@@ -79,9 +80,16 @@ namespace Comphi {
 	enum DescriptorSetResourceType {
 		ImageBufferSampler = 1, //VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
 		UniformBufferData = 6, //VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER
-		StorageBufferDynamic = 9 //VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC
+		StorageBufferData = 7, //VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+		UniformBufferDynamic = 8, //VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+		StorageBufferDynamic = 9 //VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC
 	};
 
+	//Dynamic descriptors take an offset at bind time, one set can serve many draws
+	inline bool isDynamicDescriptor(DescriptorSetResourceType type) {
+		return type == UniformBufferDynamic || type == StorageBufferDynamic;
+	}
+
 	enum LayoutSetUpdateFrequency {
 		GlobalData			= 0,
 		PerScene			= 1,
@@ -101,12 +109,32 @@ namespace Comphi {
 	struct PipelineLayoutSet {
 		std::vector<DescriptorSetBinding> shaderResourceDescriptorSetBindings;
 		LayoutSetUpdateFrequency updateFrequency;
-		//std::vector<pushConstants> //TODO: Add Later
+	};
+
+	//Written by the renderer before every indirect draw run, the first push constant range of every pipeline (vertex stage)
+	//shaders index their instance data with instanceBase + gl_InstanceIndex
+	struct DrawPushConstants {
+		uint instanceBase = 0;
+	};
+
+	//Small per draw data written straight into the command buffer (no buffer or descriptor update)
+	struct PushConstantRange {
+		ShaderStageFlag shaderStage = AllGraphics;
+		uint offset = 0; //multiple of 4
+		uint size = 0; //multiple of 4
 	};
 
 	struct PipelineLayoutConfiguration {
+		static constexpr uint MaxPushConstantsSize = 128; //minimum guaranteed by the spec (maxPushConstantsSize)
+		static constexpr uint InvalidPushConstantOffset = UINT32_MAX;
+
 		std::vector<PipelineLayoutSet> layoutSets;
+		std::vector<PushConstantRange> pushConstantRanges = { { VertexStage, 0, sizeof(DrawPushConstants) } };
 		std::vector<IShaderProgram*> shaderPrograms;
+
+		//pushConstantRanges merged into one span per stage (a stage may appear in a single range of the layout),
+		//stages with the same span share a range
+		std::vector<PushConstantRange> getLayoutPushConstantRanges() const;
 	};
 
 	struct GraphicsPipelineConfiguration {
@@ -114,6 +142,16 @@ namespace Comphi {
 		RasterizerSettings rasterizerSettings{};
 		VertexBuffersLayoutConfiguration vertexInputLayoutConfiguration{};
 		PipelineLayoutConfiguration pipelineLayoutConfiguration{};
+		std::map<ShaderType, SpecializationConstantMap> specializationConstants; //per stage, override the shader defaults
+
+		//shader defaults merged with this configuration's values for the stage of shaderProgram
+		SpecializationConstantMap getSpecializationConstants(const IShaderProgram* shaderProgram) const;
+
+		//every field the pipeline is built from, in canonical order (order independent where Vulkan is: shader stages, vertex attributes...)
+		//equal keys can share one pipeline
+		std::string getCanonicalKey() const;
+		//hash of the canonical key, compare the keys on equal hashes
+		uint64_t getHash() const;
 
 		//TODO: Add missing Configurations v v v 
 		//pViewportState = &viewportState; == //pDynamicState = &dynamicState;
@@ -134,6 +172,9 @@ namespace Comphi {
 		GraphicsPipelineConfiguration configuration;
 		virtual void initialize() = 0;
 		virtual void cleanUp() override {};
+
+		//set while initialize() runs on a background thread (see Material::initialize)
+		std::shared_future<void> compilation;
 	};
 
 	typedef std::shared_ptr<IGraphicsPipeline> IGraphicsPipelinePtr;
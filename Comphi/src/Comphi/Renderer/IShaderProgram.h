@@ -1,6 +1,7 @@
 #pragma once
 #include "Comphi/Allocation/IObject.h"
 #include "Comphi/Platform/IFileRef.h"
+#include <variant>
 
 namespace Comphi{
 
@@ -31,13 +32,26 @@ namespace Comphi{
     VK_SHADER_STAGE_ALL = 0x7FFFFFFF,
 	*/
 
+	//Specialization constants : layout(constant_id = ID) const ... (bool, int, uint or float, 4 bytes each)
+	//resolved when the pipeline is compiled, the driver strips the branches they disable
+	typedef std::variant<bool, int32_t, uint32_t, float> SpecializationConstant;
+	typedef std::map<uint, SpecializationConstant> SpecializationConstantMap; //constantID -> value (ordered, hashed as is)
+
 	class IShaderProgram : public IObject
 	{
 	public:
-		IShaderProgram(ShaderType shaderType, IFileRef& file) : m_shaderType(shaderType), shaderFile(file) {};
-		virtual const uint GetType(){ return (uint)m_shaderType; };
+		IShaderProgram(ShaderType shaderType, IFileRef& file) : m_shaderType(shaderType), shaderFile(file) {
+			const std::vector<char> byteCode = file.getByteData();
+			byteCodeSize = byteCode.size();
+			byteCodeHash = std::hash<std::string_view>()(std::string_view(byteCode.data(), byteCode.size()));
+		};
+		virtual const uint GetType() const { return (uint)m_shaderType; };
 		IFileRef& shaderFile;
+		//hashed once when loaded, part of the pipeline canonical key
+		size_t byteCodeSize = 0;
+		uint64_t byteCodeHash = 0;
 		std::string entryPointFunctionName = "main";
+		SpecializationConstantMap specializationConstants; //defaults, overridden per Material
 		virtual void cleanUp() override {};
 	protected:
 		ShaderType m_shaderType;
@@ -0,0 +1,64 @@
+#include "cphipch.h"
+#include "FrameRingBuffer.h"
+
+namespace Comphi::Vulkan {
+
+	FrameRingBuffer::FrameRingBuffer(uint frameCount, VkDeviceSize frameSize)
+	{
+		const VkPhysicalDeviceLimits& limits = GraphicsHandler::get()->deviceProperties.limits;
+		alignment = (std::max)(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+		alignment = (std::max)(alignment, (VkDeviceSize)1);
+		this->frameSize = alignUp(frameSize);
+
+		allocateMemoryBuffer(this->frameSize * frameCount,
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+		mappedData = allocation.mappedData;
+		if (mappedData == nullptr) {
+			COMPHILOG_CORE_FATAL("failed to map frame ring buffer!");
+			throw std::runtime_error("failed to map frame ring buffer!");
+		}
+
+		COMPHILOG_CORE_INFO("created FrameRingBuffer ({0} frames x {1} bytes, alignment {2})", frameCount, this->frameSize, alignment);
+	}
+
+	void FrameRingBuffer::beginFrame(uint frame)
+	{
+		frameBegin = frame * frameSize;
+		frameOffset = frameBegin;
+	}
+
+	RingAllocation FrameRingBuffer::allocate(VkDeviceSize size)
+	{
+		RingAllocation allocation;
+		VkDeviceSize alignedSize = alignUp(size);
+		if (frameOffset + alignedSize > frameBegin + frameSize) {
+			COMPHILOG_CORE_ERROR("FrameRingBuffer: frame region full, {0} bytes requested!", size);
+			return allocation;
+		}
+
+		allocation.buffer = bufferObj;
+		allocation.offset = frameOffset;
+		allocation.size = size;
+		allocation.data = static_cast<char*>(mappedData) + frameOffset;
+		frameOffset += alignedSize;
+		return allocation;
+	}
+
+	RingAllocation FrameRingBuffer::push(const void* data, VkDeviceSize size)
+	{
+		RingAllocation allocation = allocate(size);
+		if (allocation.isValid()) {
+			memcpy(allocation.data, data, (size_t)size);
+		}
+		return allocation;
+	}
+
+	void FrameRingBuffer::cleanUp()
+	{
+		mappedData = nullptr;
+		MemBuffer::cleanUp();
+	}
+
+}
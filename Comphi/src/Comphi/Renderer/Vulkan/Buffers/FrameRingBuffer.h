@@ -0,0 +1,49 @@
+#pragma once
+#include "MemBuffer.h"
+
+namespace Comphi::Vulkan {
+
+	//Sub-allocated range of a FrameRingBuffer, valid until the same frame in flight comes around again
+	struct RingAllocation {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		void* data = nullptr; //persistently mapped pointer to the range
+
+		inline bool isValid() const { return buffer != VK_NULL_HANDLE; }
+		inline VkDescriptorBufferInfo getDescriptorInfo() const { return { buffer, offset, size }; }
+	};
+
+	//Linear allocator for per-frame shader data, one region per frame in flight
+	//The whole buffer is host visible and mapped once, frame N only writes to its own region
+	//so it never overwrites data the GPU is still reading for frame N-1
+	class FrameRingBuffer : public MemBuffer
+	{
+	public:
+		static constexpr VkDeviceSize DefaultFrameSize = 1 << 20; //1MB per frame in flight
+
+		FrameRingBuffer(uint frameCount, VkDeviceSize frameSize = DefaultFrameSize);
+
+		//resets the region of frame, call after its fence was waited on
+		void beginFrame(uint frame);
+
+		//offsets are aligned to minUniformBufferOffsetAlignment / minStorageBufferOffsetAlignment
+		RingAllocation allocate(VkDeviceSize size);
+		RingAllocation push(const void* data, VkDeviceSize size);
+
+		inline VkDeviceSize getAlignment() const { return alignment; }
+		inline VkDeviceSize getFrameUsage() const { return frameOffset - frameBegin; }
+
+		void cleanUp();
+
+	private:
+		inline VkDeviceSize alignUp(VkDeviceSize size) const { return (size + alignment - 1) & ~(alignment - 1); }
+
+		VkDeviceSize frameSize = 0;
+		VkDeviceSize alignment = 1;
+		VkDeviceSize frameBegin = 0;
+		VkDeviceSize frameOffset = 0;
+		void* mappedData = nullptr;
+	};
+
+}
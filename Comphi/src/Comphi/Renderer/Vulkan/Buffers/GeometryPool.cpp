@@ -0,0 +1,120 @@
+#include "cphipch.h"
+#include "GeometryPool.h"
+
+namespace Comphi::Vulkan {
+
+	GeometryPool* GeometryPool::get()
+	{
+		static GeometryPool geometryPool;
+		return &geometryPool;
+	}
+
+	bool GeometryPool::allocateRange(std::vector<Range>& freeRanges, uint count, uint& first)
+	{
+		for (size_t i = 0; i < freeRanges.size(); i++)
+		{
+			if (freeRanges[i].count < count) continue;
+			first = freeRanges[i].first;
+			freeRanges[i].first += count;
+			freeRanges[i].count -= count;
+			if (freeRanges[i].count == 0) freeRanges.erase(freeRanges.begin() + i);
+			return true;
+		}
+		return false;
+	}
+
+	void GeometryPool::freeRange(std::vector<Range>& freeRanges, uint first, uint count)
+	{
+		if (count == 0) return;
+		auto next = std::lower_bound(freeRanges.begin(), freeRanges.end(), first, [](const Range& r, uint first) { return r.first < first; });
+		next = freeRanges.insert(next, { first, count });
+		if (next + 1 != freeRanges.end() && next->first + next->count == (next + 1)->first) {
+			next->count += (next + 1)->count;
+			freeRanges.erase(next + 1);
+		}
+		if (next != freeRanges.begin() && (next - 1)->first + (next - 1)->count == next->first) {
+			(next - 1)->count += next->count;
+			freeRanges.erase(next);
+		}
+	}
+
+	GeometryAllocation GeometryPool::allocate(const VertexArray& vertices, const IndexArray& indices)
+	{
+		std::lock_guard<std::mutex> lock(poolMutex);
+
+		GeometryAllocation allocation;
+		allocation.vertexCount = (uint)vertices.size();
+		allocation.indexCount = (uint)indices.size();
+
+		bool allocated = false;
+		for (uint i = 0; i < pages.size() && !allocated; i++)
+		{
+			Page& page = pages[i];
+			uint vertexOffset, firstIndex;
+			if (!allocateRange(page.freeVertices, allocation.vertexCount, vertexOffset)) continue;
+			if (!allocateRange(page.freeIndices, allocation.indexCount, firstIndex)) {
+				freeRange(page.freeVertices, vertexOffset, allocation.vertexCount);
+				continue;
+			}
+			allocation.vertexOffset = vertexOffset;
+			allocation.firstIndex = firstIndex;
+			allocation.pageIndex = i;
+			allocated = true;
+		}
+
+		//new page (oversized meshes get a page of their own size)
+		if (!allocated) {
+			uint vertexCapacity = (std::max)(PageVertexCount, allocation.vertexCount);
+			uint indexCapacity = (std::max)(PageIndexCount, allocation.indexCount);
+
+			Page page;
+			page.vertexBuffer = std::make_shared<UniformBuffer>(nullptr, sizeof(Vertex), vertexCapacity, BufferUsage::VertexBuffer);
+			page.indexBuffer = std::make_shared<UniformBuffer>(nullptr, sizeof(Index), indexCapacity, BufferUsage::IndexBuffer);
+			page.freeVertices.push_back({ 0, vertexCapacity });
+			page.freeIndices.push_back({ 0, indexCapacity });
+
+			allocateRange(page.freeVertices, allocation.vertexCount, allocation.vertexOffset);
+			allocateRange(page.freeIndices, allocation.indexCount, allocation.firstIndex);
+			allocation.pageIndex = (uint)pages.size();
+			pages.push_back(page);
+
+			COMPHILOG_CORE_INFO("GeometryPool: new page {0} ({1} vertices, {2} indices)", allocation.pageIndex, vertexCapacity, indexCapacity);
+		}
+
+		Page& page = pages[allocation.pageIndex];
+		allocation.vertexBuffer = page.vertexBuffer;
+		allocation.indexBuffer = page.indexBuffer;
+
+		//upload only the mesh range, indices stay relative to the mesh (vertexOffset is added by the draw)
+		allocation.vertexBuffer->updateBufferData(vertices.data(), (VkDeviceSize)allocation.vertexOffset * sizeof(Vertex), (VkDeviceSize)allocation.vertexCount * sizeof(Vertex));
+		allocation.indexBuffer->updateBufferData(indices.data(), (VkDeviceSize)allocation.firstIndex * sizeof(Index), (VkDeviceSize)allocation.indexCount * sizeof(Index));
+
+		return allocation;
+	}
+
+	void GeometryPool::free(GeometryAllocation& allocation)
+	{
+		if (!allocation.isValid()) return;
+
+		std::lock_guard<std::mutex> lock(poolMutex);
+		if (allocation.pageIndex < pages.size()) {
+			Page& page = pages[allocation.pageIndex];
+			freeRange(page.freeVertices, allocation.vertexOffset, allocation.vertexCount);
+			freeRange(page.freeIndices, allocation.firstIndex, allocation.indexCount);
+		}
+		allocation = GeometryAllocation();
+	}
+
+	void GeometryPool::cleanUp()
+	{
+		std::lock_guard<std::mutex> lock(poolMutex);
+		for (auto& page : pages)
+		{
+			page.vertexBuffer->cleanUp();
+			page.indexBuffer->cleanUp();
+		}
+		COMPHILOG_CORE_INFO("vkDestroy Destroy GeometryPool pages");
+		pages.clear();
+	}
+
+}
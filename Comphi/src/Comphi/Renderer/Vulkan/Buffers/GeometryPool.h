@@ -0,0 +1,54 @@
+#pragma once
+#include "UniformBuffer.h"
+#include "Comphi/Utils/ModelLoader.h"
+#include <mutex>
+
+namespace Comphi::Vulkan {
+
+	//Mesh range inside the GeometryPool, drawn with firstIndex & vertexOffset
+	struct GeometryAllocation {
+		std::shared_ptr<UniformBuffer> vertexBuffer;
+		std::shared_ptr<UniformBuffer> indexBuffer;
+		uint vertexOffset = 0;
+		uint vertexCount = 0;
+		uint firstIndex = 0;
+		uint indexCount = 0;
+		uint pageIndex = 0;
+		inline bool isValid() const { return vertexBuffer.get() != nullptr; }
+	};
+
+	//Shared device local vertex/index buffers that every mesh is sub-allocated into (first fit, in elements)
+	//Meshes of the same page share their buffer binds, so a batch is drawn with one bind and one indirect draw
+	class GeometryPool
+	{
+	public:
+		static constexpr uint PageVertexCount = 512 * 1024; //16 MB of Vertex
+		static constexpr uint PageIndexCount = 2 * 1024 * 1024; //8 MB of Index
+
+		static GeometryPool* get();
+
+		GeometryAllocation allocate(const VertexArray& vertices, const IndexArray& indices);
+		void free(GeometryAllocation& allocation);
+		void cleanUp();
+
+	private:
+		struct Range {
+			uint first;
+			uint count;
+		};
+
+		struct Page {
+			std::shared_ptr<UniformBuffer> vertexBuffer;
+			std::shared_ptr<UniformBuffer> indexBuffer;
+			std::vector<Range> freeVertices; //sorted by first, adjacent ranges merged
+			std::vector<Range> freeIndices;
+		};
+
+		static bool allocateRange(std::vector<Range>& freeRanges, uint count, uint& first);
+		static void freeRange(std::vector<Range>& freeRanges, uint first, uint count);
+
+		std::vector<Page> pages;
+		std::mutex poolMutex;
+	};
+
+}
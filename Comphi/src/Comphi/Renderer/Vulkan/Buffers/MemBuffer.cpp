@@ -1,6 +1,6 @@
 #include "cphipch.h"
 #include "MemBuffer.h"
-#include "Comphi/Renderer/Vulkan/Commands/CommandPool.h"
+#include "Comphi/Renderer/Vulkan/Memory/DeferredDeletionQueue.h"
 
 namespace Comphi::Vulkan {
     
@@ -17,27 +17,17 @@ namespace Comphi::Vulkan {
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
         bufferInfo.size = size;
         bufferInfo.usage = usage;
-        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE; //upload destinations change queue family ownership (UploadManager)
 
         vkCheckError(vkCreateBuffer(GraphicsHandler::get()->logicalDevice, &bufferInfo, nullptr, &bufferObj)) {
             COMPHILOG_CORE_ERROR("failed to create buffer!");
             throw std::runtime_error("failed to create buffer!");
         }
 
-        VkMemoryRequirements memRequirements;
-        vkGetBufferMemoryRequirements(GraphicsHandler::get()->logicalDevice, bufferObj, &memRequirements);
-
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = MemBuffer::findMemoryType(memRequirements.memoryTypeBits, properties);
+        allocation = DeviceMemoryAllocator::get()->allocateForBuffer(bufferObj, properties);
 
-        vkCheckError(vkAllocateMemory(GraphicsHandler::get()->logicalDevice, &allocInfo, nullptr, &bufferMemory)) {
-            COMPHILOG_CORE_ERROR("failed to allocate vertex buffer memory!");
-            throw std::runtime_error("failed to allocate vertex buffer memory!");
-        }
-
-        vkBindBufferMemory(GraphicsHandler::get()->logicalDevice, bufferObj, bufferMemory, 0);
+        vkBindBufferMemory(GraphicsHandler::get()->logicalDevice, bufferObj, allocation.memory, allocation.offset);
     }
 
     uint32_t MemBuffer::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
@@ -55,25 +45,20 @@ namespace Comphi::Vulkan {
 
     }
 
-
-    void MemBuffer::copyBufferTo(VkBuffer& srcBuffer, VkBuffer& dstBuffer, uint copySize)
-    {
-        CommandBuffer commandBuffer = CommandPool::beginCommandBuffer(TransferCommand);
-
-        VkBufferCopy copyRegion{};
-        //copyRegion.srcOffset = 0; // Optional
-        //copyRegion.dstOffset = 0; // Optional
-        copyRegion.size = copySize;
-        vkCmdCopyBuffer(commandBuffer.buffer, srcBuffer, dstBuffer, 1, &copyRegion);
-
-        CommandPool::endCommandBuffer(commandBuffer);
-    }
-    
     void MemBuffer::cleanUp()
     {
-        COMPHILOG_CORE_INFO("vkDestroy Destroy MemBuffer");
-        vkDestroyBuffer(GraphicsHandler::get()->logicalDevice, bufferObj, nullptr);
-        vkFreeMemory(GraphicsHandler::get()->logicalDevice, bufferMemory, nullptr);
+        if (bufferObj == VK_NULL_HANDLE) return; //already cleaned up (explicit cleanUp + destructor)
+
+        //in flight frames may still read the buffer, destroyed once they retired
+        VkBuffer buffer = bufferObj;
+        MemoryAllocation bufferAllocation = allocation;
+        bufferObj = VK_NULL_HANDLE;
+        allocation = MemoryAllocation();
+        DeferredDeletionQueue::get()->enqueue([buffer, bufferAllocation]() mutable {
+            COMPHILOG_CORE_INFO("vkDestroy Destroy MemBuffer");
+            vkDestroyBuffer(GraphicsHandler::get()->logicalDevice, buffer, nullptr);
+            DeviceMemoryAllocator::get()->free(bufferAllocation);
+        });
     }
 
 }
\ No newline at end of file
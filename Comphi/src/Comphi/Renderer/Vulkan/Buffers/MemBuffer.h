@@ -1,6 +1,7 @@
 #pragma once
 #include "Comphi/Renderer/IUniformBuffer.h"
 #include "Comphi/Renderer/Vulkan/GraphicsHandler.h"
+#include "Comphi/Renderer/Vulkan/Memory/DeviceMemoryAllocator.h"
 
 namespace Comphi::Vulkan {
 
@@ -12,12 +13,11 @@ namespace Comphi::Vulkan {
 		MemBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
 
 		static uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
-		static void copyBufferTo(VkBuffer& srcBuffer, VkBuffer& dstBuffer, uint copySize);
 
 		void allocateMemoryBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
 
-		VkBuffer bufferObj;
-		VkDeviceMemory bufferMemory;
+		VkBuffer bufferObj = VK_NULL_HANDLE;
+		MemoryAllocation allocation; //sub-allocated by the DeviceMemoryAllocator, host visible memory is already mapped
 		VkDeviceSize bufferSize;
 
 		void cleanUp();
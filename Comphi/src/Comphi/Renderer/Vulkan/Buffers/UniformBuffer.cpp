@@ -1,5 +1,6 @@
 #include "cphipch.h"
 #include "UniformBuffer.h"
+#include "UploadManager.h"
 
 namespace Comphi::Vulkan {
     
@@ -40,34 +41,46 @@ namespace Comphi::Vulkan {
         allocateMemoryBuffer(bufferSize,
             usageFlags, accessFlags);
 
-        if (bufferUsage == BufferUsage::UniformBuffer) return;
+        if (isHostVisible()) {
+            mappedData = allocation.mappedData;
+        }
+
+        if (bufferUsage == BufferUsage::UniformBuffer || dataArray == nullptr) return;
 
         updateBufferData(dataArray);
     }
 
     void Comphi::Vulkan::UniformBuffer::updateBufferData(const void* dataArray)
     {
-        if (bufferUsage == BufferUsage::UniformBuffer) {
-            copyData(*this, dataArray);
+        //host visible buffers are written directly, no staging copy
+        if (mappedData != nullptr) {
+            memcpy(mappedData, dataArray, (size_t)bufferSize);
             return;
         }
 
-        MemBuffer stagingBuffer(bufferSize,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-        copyData(stagingBuffer, dataArray);
+        //staged & batched on the transfer queue, visible to the next submitted frame
+        UploadManager::get()->uploadBuffer(bufferObj, 0, dataArray, bufferSize);
+    }
 
-        MemBuffer::copyBufferTo(stagingBuffer.bufferObj, bufferObj, (size_t)bufferSize);
+    void UniformBuffer::updateBufferData(const void* dataArray, VkDeviceSize offset, VkDeviceSize size)
+    {
+        if (size == 0) return;
+        if (mappedData != nullptr) {
+            memcpy(static_cast<char*>(mappedData) + offset, dataArray, (size_t)size);
+            return;
+        }
 
-        //cleanup
-        stagingBuffer.cleanUp();
+        UploadManager::get()->uploadBuffer(bufferObj, offset, dataArray, size);
     }
 
     void UniformBuffer::copyData(const MemBuffer& membuffer, const void* dataArray)
     {
-        void* deviceMemoryData;
-        vkMapMemory(GraphicsHandler::get()->logicalDevice, membuffer.bufferMemory, 0, membuffer.bufferSize, 0, &deviceMemoryData);
-        memcpy(deviceMemoryData, dataArray, (size_t)bufferSize);
-        vkUnmapMemory(GraphicsHandler::get()->logicalDevice, membuffer.bufferMemory);
+        memcpy(membuffer.allocation.mappedData, dataArray, (size_t)bufferSize);
+    }
+
+    void UniformBuffer::cleanUp()
+    {
+        mappedData = nullptr; //unmapped with its memory block
+        static_cast<MemBuffer*>(this)->cleanUp();
     }
 }
\ No newline at end of file
@@ -10,10 +10,13 @@ namespace Comphi::Vulkan {
         UniformBuffer(const void* dataArray, const uint size, const uint count, BufferUsage usage = BufferUsage::UniformBuffer);
         //Initialize(const T* dataArray, const uint count, BufferUsage usage = BufferUsage::UniformBuffer);
         virtual void updateBufferData(const void* dataArray) override;
-        virtual void cleanUp() override { static_cast<MemBuffer*>(this)->cleanUp(); }
+        void updateBufferData(const void* dataArray, VkDeviceSize offset, VkDeviceSize size); //sub range (GeometryPool meshes)
+        virtual void cleanUp() override;
         ~UniformBuffer() { cleanUp(); }
     private :
         void copyData(const MemBuffer& membuffer, const void* dataArray);
+        inline bool isHostVisible() const { return bufferUsage == BufferUsage::UniformBuffer || bufferUsage == BufferUsage::BufferStorageDynamic || bufferUsage == BufferUsage::DrawIndirect; }
+        void* mappedData = nullptr; //host visible buffers stay mapped for their whole lifetime (allocation.mappedData)
     };
 
    
@@ -0,0 +1,435 @@
+#include "cphipch.h"
+#include "UploadManager.h"
+#include "Comphi/Renderer/Vulkan/Images/ImageBufer.h"
+#include "Comphi/Renderer/Vulkan/Commands/CommandPool.h"
+
+namespace Comphi::Vulkan {
+
+	static inline VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	UploadManager* UploadManager::get()
+	{
+		static UploadManager uploadManager;
+		return &uploadManager;
+	}
+
+	void UploadManager::initialize()
+	{
+		stagingRing.allocateMemoryBuffer(StagingRingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		initialized = true;
+
+		COMPHILOG_CORE_INFO("created UploadManager ({0} bytes staging ring)", StagingRingSize);
+	}
+
+	bool UploadManager::allocateStaging(VkDeviceSize size, VkDeviceSize& offset)
+	{
+		//an empty ring starts over
+		if (inFlightBatches.empty() && pendingCopies.empty() && pendingImageCopies.empty()) {
+			ringHead = ringTail = 0;
+		}
+
+		size = alignUp(size, StagingAlignment);
+		if (ringHead >= ringTail) {
+			//free : [head, size) and [0, tail), head never catches up with the tail
+			if (ringHead + size <= StagingRingSize) {
+				offset = ringHead;
+				ringHead += size;
+				return true;
+			}
+			if (size < ringTail) {
+				offset = 0;
+				ringHead = size;
+				return true;
+			}
+			return false;
+		}
+
+		//free : [head, tail)
+		if (ringHead + size < ringTail) {
+			offset = ringHead;
+			ringHead += size;
+			return true;
+		}
+		return false;
+	}
+
+	void UploadManager::stage(const void* data, VkDeviceSize size, VkBuffer& srcBuffer, VkDeviceSize& srcOffset)
+	{
+		if (size > StagingRingSize / 2) {
+			//oversized : own staging buffer, released with the batch
+			MemBuffer stagingBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			memcpy(stagingBuffer.allocation.mappedData, data, (size_t)size);
+			pendingOversizedStagingBuffers.push_back(stagingBuffer);
+			srcBuffer = stagingBuffer.bufferObj;
+			srcOffset = 0;
+			return;
+		}
+
+		while (!allocateStaging(size, srcOffset))
+		{
+			//ring full : submit what is pending and wait for the oldest batch to free its space
+			submitPending();
+			retireBatches(true);
+		}
+
+		memcpy(static_cast<char*>(stagingRing.allocation.mappedData) + srcOffset, data, (size_t)size);
+		srcBuffer = stagingRing.bufferObj;
+	}
+
+	void UploadManager::uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size)
+	{
+		if (size == 0) return;
+
+		std::lock_guard<std::mutex> lock(uploadMutex);
+		if (!initialized) initialize();
+
+		//copies inside one batch are unordered, overlapping writes go to the next batch
+		for (const auto& copy : pendingCopies) {
+			bool overlaps = dstOffset < copy.region.dstOffset + copy.region.size && copy.region.dstOffset < dstOffset + size;
+			if (copy.dstBuffer == dstBuffer && overlaps) {
+				submitPending();
+				break;
+			}
+		}
+
+		PendingCopy copy;
+		copy.dstBuffer = dstBuffer;
+		copy.region.dstOffset = dstOffset;
+		copy.region.size = size;
+		stage(data, size, copy.srcBuffer, copy.region.srcOffset);
+		pendingCopies.push_back(copy);
+	}
+
+	void UploadManager::uploadImage(ImageBuffer& image, const void* data, VkDeviceSize size)
+	{
+		std::lock_guard<std::mutex> lock(uploadMutex);
+		if (!initialized) initialize();
+
+		PendingImageCopy copy;
+		copy.image = &image;
+		stage(data, size, copy.srcBuffer, copy.srcOffset);
+		pendingImageCopies.push_back(copy);
+	}
+
+	void UploadManager::cancelImage(ImageBuffer& image)
+	{
+		std::lock_guard<std::mutex> lock(uploadMutex);
+
+		//not recorded yet : its staging space is reclaimed with the next batch
+		pendingImageCopies.erase(std::remove_if(pendingImageCopies.begin(), pendingImageCopies.end(),
+			[&image](const PendingImageCopy& copy) { return copy.image == &image; }), pendingImageCopies.end());
+
+		//submitted : the transfer queue may still be writing it
+		bool submitted = false;
+		for (auto& signaled : signaledBatches) {
+			auto it = std::find(signaled.images.begin(), signaled.images.end(), &image);
+			if (it != signaled.images.end()) {
+				signaled.images.erase(it);
+				submitted = true;
+			}
+		}
+		while (submitted && !inFlightBatches.empty()) {
+			retireBatches(true);
+		}
+	}
+
+	void UploadManager::recordImageCopies(VkCommandBuffer commandBuffer)
+	{
+		if (pendingImageCopies.empty()) return;
+
+		uint32_t transferFamily = GraphicsHandler::get()->transferQueueFamily.index;
+		uint32_t graphicsFamily = GraphicsHandler::get()->graphicsQueueFamily.index;
+		bool ownershipTransfer = transferFamily != graphicsFamily;
+
+		std::vector<VkImageMemoryBarrier> barriers(pendingImageCopies.size());
+		for (size_t i = 0; i < pendingImageCopies.size(); i++)
+		{
+			VkImageMemoryBarrier& barrier = barriers[i];
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.image = pendingImageCopies[i].image->imageReference;
+			barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_NONE;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		}
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
+
+		for (const auto& copy : pendingImageCopies)
+		{
+			VkBufferImageCopy region{};
+			region.bufferOffset = copy.srcOffset;
+			region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+			region.imageExtent = { copy.image->imageExtent.width, copy.image->imageExtent.height, 1 };
+			vkCmdCopyBufferToImage(commandBuffer, copy.srcBuffer, copy.image->imageReference, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+		}
+
+		//release : ownership goes to the graphics queue with the final layout, the acquire repeats this barrier
+		for (auto& barrier : barriers)
+		{
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_NONE;
+			if (ownershipTransfer) {
+				barrier.srcQueueFamilyIndex = transferFamily;
+				barrier.dstQueueFamilyIndex = graphicsFamily;
+			}
+		}
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0, 0, nullptr, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
+	}
+
+	std::vector<VkBufferMemoryBarrier> UploadManager::recordBufferRelease(VkCommandBuffer commandBuffer)
+	{
+		uint32_t transferFamily = GraphicsHandler::get()->transferQueueFamily.index;
+		uint32_t graphicsFamily = GraphicsHandler::get()->graphicsQueueFamily.index;
+		if (pendingCopies.empty() || transferFamily == graphicsFamily) return {};
+
+		//release : the copied ranges go to the graphics queue, the acquire repeats these barriers
+		std::vector<VkBufferMemoryBarrier> barriers(pendingCopies.size());
+		for (size_t i = 0; i < pendingCopies.size(); i++)
+		{
+			VkBufferMemoryBarrier& barrier = barriers[i];
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			barrier.buffer = pendingCopies[i].dstBuffer;
+			barrier.offset = pendingCopies[i].region.dstOffset;
+			barrier.size = pendingCopies[i].region.size;
+			barrier.srcQueueFamilyIndex = transferFamily;
+			barrier.dstQueueFamilyIndex = graphicsFamily;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_NONE;
+		}
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0, 0, nullptr, (uint32_t)barriers.size(), barriers.data(), 0, nullptr);
+
+		for (auto& barrier : barriers)
+		{
+			barrier.srcAccessMask = VK_ACCESS_NONE;
+			barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+				| VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+		}
+		return barriers;
+	}
+
+	void UploadManager::recordAcquireBarriers(VkCommandBuffer commandBuffer, uint frame)
+	{
+		std::lock_guard<std::mutex> lock(uploadMutex);
+		if (!initialized) return;
+		if (frame >= frameWaitSemaphores.size()) frameWaitSemaphores.resize(frame + 1);
+
+		retireBatches(false);
+		submitPending();
+
+		uint32_t transferFamily = GraphicsHandler::get()->transferQueueFamily.index;
+		uint32_t graphicsFamily = GraphicsHandler::get()->graphicsQueueFamily.index;
+		bool ownershipTransfer = transferFamily != graphicsFamily;
+
+		std::vector<VkImageMemoryBarrier> barriers;
+		std::vector<VkBufferMemoryBarrier> bufferBarriers;
+		for (auto it = signaledBatches.begin(); it != signaledBatches.end();)
+		{
+			if (!it->needsAcquire()) {
+				it++;
+				continue;
+			}
+
+			bufferBarriers.insert(bufferBarriers.end(), it->bufferAcquires.begin(), it->bufferAcquires.end());
+
+			for (ImageBuffer* image : it->images)
+			{
+				VkImageMemoryBarrier barrier{};
+				barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				barrier.image = image->imageReference;
+				barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+				barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				barrier.srcAccessMask = VK_ACCESS_NONE;
+				barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+				barrier.srcQueueFamilyIndex = ownershipTransfer ? transferFamily : VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = ownershipTransfer ? graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+				if (ownershipTransfer) barriers.push_back(barrier);
+
+				image->imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				image->resident = true;
+			}
+
+			//the frame waits on the batch, so its copies are done before the acquire executes
+			frameWaitSemaphores[frame].push_back(it->semaphore);
+			it = signaledBatches.erase(it);
+		}
+
+		if (barriers.empty() && bufferBarriers.empty()) return;
+		VkPipelineStageFlags dstStages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
+			| VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStages,
+			0, 0, nullptr, (uint32_t)bufferBarriers.size(), bufferBarriers.data(), (uint32_t)barriers.size(), barriers.data());
+	}
+
+	void UploadManager::flush()
+	{
+		std::lock_guard<std::mutex> lock(uploadMutex);
+		if (!initialized) return;
+
+		retireBatches(false);
+		submitPending();
+	}
+
+	void UploadManager::submitPending()
+	{
+		if (pendingCopies.empty() && pendingImageCopies.empty()) return;
+
+		UploadBatch batch;
+		batch.semaphore = acquireSemaphore();
+		batch.ringEnd = ringHead;
+
+		//recycled one-shot transfer buffer, its ticket tells when the ring space is free again
+		CommandBuffer commandBuffer = CommandPool::beginCommandBuffer(TransferCommand);
+		commandBuffer.signalSemaphore = &batch.semaphore;
+
+		//overlapping buffer writes are split across batches : order them after the copies of the previous batches
+		VkMemoryBarrier batchBarrier{};
+		batchBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		batchBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		batchBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer.buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 1, &batchBarrier, 0, nullptr, 0, nullptr);
+
+		recordImageCopies(commandBuffer.buffer);
+
+		//one vkCmdCopyBuffer per source/destination pair
+		std::stable_sort(pendingCopies.begin(), pendingCopies.end(), [](const PendingCopy& a, const PendingCopy& b) {
+			if (a.dstBuffer != b.dstBuffer) return std::less<VkBuffer>()(a.dstBuffer, b.dstBuffer);
+			return std::less<VkBuffer>()(a.srcBuffer, b.srcBuffer);
+		});
+		std::vector<VkBufferCopy> regions;
+		for (size_t i = 0; i < pendingCopies.size(); i++)
+		{
+			regions.push_back(pendingCopies[i].region);
+			bool lastOfGroup = i + 1 == pendingCopies.size()
+				|| pendingCopies[i + 1].dstBuffer != pendingCopies[i].dstBuffer
+				|| pendingCopies[i + 1].srcBuffer != pendingCopies[i].srcBuffer;
+			if (lastOfGroup) {
+				vkCmdCopyBuffer(commandBuffer.buffer, pendingCopies[i].srcBuffer, pendingCopies[i].dstBuffer, (uint32_t)regions.size(), regions.data());
+				regions.clear();
+			}
+		}
+		std::vector<VkBufferMemoryBarrier> bufferAcquires = recordBufferRelease(commandBuffer.buffer);
+
+		batch.ticket = CommandPool::submitCommandBuffer(commandBuffer);
+
+		batch.oversizedStagingBuffers = std::move(pendingOversizedStagingBuffers);
+		pendingOversizedStagingBuffers.clear();
+		pendingCopies.clear();
+
+		SignaledBatch signaled;
+		signaled.semaphore = batch.semaphore;
+		signaled.bufferAcquires = std::move(bufferAcquires);
+		for (const auto& copy : pendingImageCopies) {
+			signaled.images.push_back(copy.image);
+		}
+		pendingImageCopies.clear();
+		signaledBatches.push_back(signaled);
+		inFlightBatches.push_back(std::move(batch));
+	}
+
+	void UploadManager::retireBatches(bool wait)
+	{
+		bool waited = false;
+		while (!inFlightBatches.empty())
+		{
+			UploadBatch& batch = inFlightBatches.front();
+			if (wait && !waited) {
+				//only the oldest batch, enough to free ring space
+				CommandPool::waitCommandTicket(batch.ticket);
+				waited = true;
+			}
+			else if (!CommandPool::isCommandTicketComplete(batch.ticket)) {
+				break;
+			}
+
+			ringTail = batch.ringEnd;
+			for (auto& stagingBuffer : batch.oversizedStagingBuffers) {
+				stagingBuffer.cleanUp();
+			}
+			inFlightBatches.pop_front();
+		}
+	}
+
+	void UploadManager::waitIdle()
+	{
+		std::lock_guard<std::mutex> lock(uploadMutex);
+		if (!initialized) return;
+
+		submitPending();
+		while (!inFlightBatches.empty()) {
+			retireBatches(true);
+		}
+	}
+
+	void UploadManager::beginFrame(uint frame)
+	{
+		std::lock_guard<std::mutex> lock(uploadMutex);
+		if (frame >= frameWaitSemaphores.size()) return;
+
+		freeSemaphores.insert(freeSemaphores.end(), frameWaitSemaphores[frame].begin(), frameWaitSemaphores[frame].end());
+		frameWaitSemaphores[frame].clear();
+	}
+
+	std::vector<VkSemaphore> UploadManager::consumeWaitSemaphores(uint frame)
+	{
+		std::lock_guard<std::mutex> lock(uploadMutex);
+		if (frame >= frameWaitSemaphores.size()) frameWaitSemaphores.resize(frame + 1);
+
+		//image & released buffer batches stay until a frame recorded their acquire
+		for (auto it = signaledBatches.begin(); it != signaledBatches.end();)
+		{
+			if (it->needsAcquire()) {
+				it++;
+				continue;
+			}
+			frameWaitSemaphores[frame].push_back(it->semaphore);
+			it = signaledBatches.erase(it);
+		}
+		return frameWaitSemaphores[frame];
+	}
+
+	VkSemaphore UploadManager::acquireSemaphore()
+	{
+		if (!freeSemaphores.empty()) {
+			VkSemaphore semaphore = freeSemaphores.back();
+			freeSemaphores.pop_back();
+			return semaphore;
+		}
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		VkSemaphore semaphore;
+		vkCheckError(vkCreateSemaphore(GraphicsHandler::get()->logicalDevice, &semaphoreInfo, nullptr, &semaphore)) {
+			COMPHILOG_CORE_FATAL("failed to create upload semaphore!");
+			throw std::runtime_error("failed to create upload semaphore!");
+		}
+		allSemaphores.push_back(semaphore);
+		return semaphore;
+	}
+
+	void UploadManager::cleanUp()
+	{
+		if (!initialized) return;
+		waitIdle();
+
+		std::lock_guard<std::mutex> lock(uploadMutex);
+		VkDevice device = GraphicsHandler::get()->logicalDevice;
+		for (auto semaphore : allSemaphores) vkDestroySemaphore(device, semaphore, nullptr);
+		allSemaphores.clear(); freeSemaphores.clear(); signaledBatches.clear(); frameWaitSemaphores.clear();
+
+		stagingRing.cleanUp();
+		initialized = false;
+	}
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include "MemBuffer.h"
+#include "Comphi/Renderer/Vulkan/Commands/TransientCommandPools.h"
+#include <mutex>
+#include <deque>
+
+namespace Comphi::Vulkan {
+
+	class ImageBuffer;
+
+	//Batches device local uploads through a shared staging ring on the transfer queue
+	//Data is copied into the (persistently mapped) ring right away, the copies are recorded and
+	//submitted together on flush() as one TransientCommandPools buffer, ring space is reused once its ticket completed
+	//Each submitted batch signals a semaphore the next graphics submit waits on (consumeWaitSemaphores)
+	//Images & buffer ranges are released by the transfer queue in their batch and acquired at the start of a frame (recordAcquireBarriers)
+	//so device local data uploaded during a frame's recording is only read from the next frame on
+	class UploadManager
+	{
+	public:
+		static constexpr VkDeviceSize StagingRingSize = 16 * 1024 * 1024;
+		static constexpr VkDeviceSize StagingAlignment = 16; //covers texel & copy offset requirements
+
+		static UploadManager* get();
+
+		//dst must have VK_BUFFER_USAGE_TRANSFER_DST_BIT, data can be released after the call
+		//the previous content of the range is discarded (it isn't handed back from the graphics queue)
+		void uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+		//whole image copy (UNDEFINED -> SHADER_READ_ONLY_OPTIMAL), image.resident is set once a frame acquired it
+		void uploadImage(ImageBuffer& image, const void* data, VkDeviceSize size);
+		//drops the pending uploads of an image about to be destroyed
+		void cancelImage(ImageBuffer& image);
+
+		//submits every pending copy as one transfer batch (no-op without pending copies)
+		void flush();
+		//blocks until every submitted batch is done
+		void waitIdle();
+
+		//called after the frame's fence was waited on : recycles the semaphores that frame waited on
+		void beginFrame(uint frame);
+		//outside of a render pass : submits the pending uploads & acquires their images & buffer ranges on the graphics queue
+		void recordAcquireBarriers(VkCommandBuffer commandBuffer, uint frame);
+		//every semaphore the graphics submit of frame has to wait on
+		//(batches with an ownership transfer are only waited on by the frame that acquires them)
+		std::vector<VkSemaphore> consumeWaitSemaphores(uint frame);
+
+		void cleanUp();
+
+	private:
+		struct PendingCopy {
+			VkBuffer srcBuffer; //staging ring or an oversized staging buffer
+			VkBuffer dstBuffer;
+			VkBufferCopy region;
+		};
+
+		struct PendingImageCopy {
+			VkBuffer srcBuffer;
+			VkDeviceSize srcOffset;
+			ImageBuffer* image;
+		};
+
+		struct SignaledBatch {
+			VkSemaphore semaphore;
+			std::vector<ImageBuffer*> images; //released, waiting for a graphics queue acquire
+			std::vector<VkBufferMemoryBarrier> bufferAcquires; //released ranges, empty when both queues share a family
+
+			inline bool needsAcquire() const { return !images.empty() || !bufferAcquires.empty(); }
+		};
+
+		struct UploadBatch {
+			CommandTicket ticket;
+			VkSemaphore semaphore;
+			VkDeviceSize ringEnd; //ring head when submitted, the tail moves here once the ticket completed
+			std::vector<MemBuffer> oversizedStagingBuffers;
+		};
+
+		void initialize();
+		bool allocateStaging(VkDeviceSize size, VkDeviceSize& offset);
+		void stage(const void* data, VkDeviceSize size, VkBuffer& srcBuffer, VkDeviceSize& srcOffset);
+		void recordImageCopies(VkCommandBuffer commandBuffer);
+		std::vector<VkBufferMemoryBarrier> recordBufferRelease(VkCommandBuffer commandBuffer);
+		void submitPending();
+		void retireBatches(bool wait);
+		VkSemaphore acquireSemaphore();
+
+		bool initialized = false;
+		std::mutex uploadMutex;
+
+		MemBuffer stagingRing;
+		VkDeviceSize ringHead = 0;
+		VkDeviceSize ringTail = 0;
+
+		std::vector<PendingCopy> pendingCopies;
+		std::vector<PendingImageCopy> pendingImageCopies;
+		std::vector<MemBuffer> pendingOversizedStagingBuffers; //uploads bigger than the ring
+		std::deque<UploadBatch> inFlightBatches;
+
+		std::vector<VkSemaphore> freeSemaphores;
+		std::vector<SignaledBatch> signaledBatches; //submitted, not waited on yet
+		std::vector<std::vector<VkSemaphore>> frameWaitSemaphores; //[frame] waited on by that frame's submit
+		std::vector<VkSemaphore> allSemaphores;
+	};
+
+}
@@ -70,93 +70,27 @@ namespace Comphi::Vulkan {
 
     CommandBuffer CommandPool::beginCommandBuffer(CommandQueueOperation op)
     {
-        VkCommandPool commandPool = getCommandPool(op);
-
-        CommandBuffer commandBuffer = { op };
-
-        VkCommandBufferAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandPool = commandPool;
-        allocInfo.commandBufferCount = 1; //how many command buffers to create
-
-        vkAllocateCommandBuffers(GraphicsHandler::get()->logicalDevice, &allocInfo, &commandBuffer.buffer);
-
-        VkCommandBufferBeginInfo beginInfo{};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-        vkBeginCommandBuffer(commandBuffer.buffer, &beginInfo);
-
-        return commandBuffer;
-
+        return TransientCommandPools::get()->begin(op);
     }
 
-    void CommandPool::endCommandBuffer(CommandBuffer& commandBuffer)
+    CommandTicket CommandPool::submitCommandBuffer(CommandBuffer& commandBuffer)
     {
-        VkQueue commandQueue = getCommandQueue(commandBuffer.op);
-        VkCommandPool commandPool = getCommandPool(commandBuffer.op);
-
-        vkEndCommandBuffer(commandBuffer.buffer);
-
-        VkSubmitInfo submitInfo{};
-        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &commandBuffer.buffer;
-
-        if (commandBuffer.signalSemaphore != VK_NULL_HANDLE) {
-            submitInfo.signalSemaphoreCount = 1;
-            submitInfo.pSignalSemaphores = commandBuffer.signalSemaphore;
-        } 
-        
-        if (commandBuffer.waitSemaphore != VK_NULL_HANDLE) {
-            submitInfo.waitSemaphoreCount = 1;
-            submitInfo.pWaitSemaphores = commandBuffer.waitSemaphore;
-            submitInfo.pWaitDstStageMask = commandBuffer.waitDstStageMask;
-        }
-
-        if (commandBuffer.fence != VK_NULL_HANDLE) {
-            vkQueueSubmit(commandQueue, 1, &submitInfo, *commandBuffer.fence);
-            vkWaitForFences(GraphicsHandler::get()->logicalDevice, 1, commandBuffer.fence, VK_TRUE, UINT64_MAX);
-            vkResetFences(GraphicsHandler::get()->logicalDevice, 1, commandBuffer.fence);
-            vkFreeCommandBuffers(GraphicsHandler::get()->logicalDevice, commandPool, 1, &commandBuffer.buffer);
-            //vkFreeCommandBuffers is typically called once per frame, not immediately after the command buffer is submitted. 
-            //This is because you typically want to keep the command buffer around for a little while in case you need to resubmit it.
-        }
-        else {
-            vkQueueSubmit(commandQueue, 1, &submitInfo, 0);
-            vkQueueWaitIdle(commandQueue);
-            vkFreeCommandBuffers(GraphicsHandler::get()->logicalDevice, commandPool, 1, &commandBuffer.buffer);
-        }
-
-        
+        return TransientCommandPools::get()->submit(commandBuffer);
     }
 
-    VkCommandPool CommandPool::getCommandPool(CommandQueueOperation& op) {
-        switch (op)
-        {
-        case TransferCommand:
-            return GraphicsHandler::get()->transferQueueFamily.commandPool;
-            break;
-        case GraphicsCommand:
-        default:
-            return GraphicsHandler::get()->graphicsQueueFamily.commandPool;
-            break;
-        }
+    bool CommandPool::isCommandTicketComplete(const CommandTicket& ticket)
+    {
+        return TransientCommandPools::get()->isComplete(ticket);
+    }
 
+    void CommandPool::waitCommandTicket(const CommandTicket& ticket)
+    {
+        TransientCommandPools::get()->wait(ticket);
     }
 
-    VkQueue CommandPool::getCommandQueue(CommandQueueOperation& op) {
-        switch (op)
-        {
-        case TransferCommand:
-            return GraphicsHandler::get()->transferQueueFamily.queue;
-            break;
-        case GraphicsCommand:
-        default:
-            return GraphicsHandler::get()->graphicsQueueFamily.queue;
-            break;
-        }
+    void CommandPool::endCommandBuffer(CommandBuffer& commandBuffer)
+    {
+        waitCommandTicket(submitCommandBuffer(commandBuffer));
     }
 
 	void CommandPool::cleanUp()
@@ -2,28 +2,22 @@
 #include "Comphi/Renderer/Vulkan/GraphicsHandler.h"
 #include "Comphi/Renderer/Vulkan/Sync/SyncObjectsFactory.h"
 #include "Comphi/Renderer/IGraphicsPipeline.h"
+#include "TransientCommandPools.h"
 
 namespace Comphi::Vulkan {
 
-	enum CommandQueueOperation { TransferCommand, GraphicsCommand };
-
-	struct CommandBuffer {
-		CommandQueueOperation op;
-		VkCommandBuffer buffer;
-		VkFence* fence;
-		VkSemaphore* signalSemaphore;
-		VkSemaphore* waitSemaphore;
-		VkPipelineStageFlags* waitDstStageMask;
-	};
-
 	//Allocator for CommandBuffers
 	class CommandPool
 	{
 	public:
 		CommandPool(); 
 
+		//one-shot command buffers, recycled by the TransientCommandPools
 		static CommandBuffer beginCommandBuffer(CommandQueueOperation op);
-		static void endCommandBuffer(CommandBuffer& commandBuffer);
+		static CommandTicket submitCommandBuffer(CommandBuffer& commandBuffer); //doesn't wait
+		static bool isCommandTicketComplete(const CommandTicket& ticket);
+		static void waitCommandTicket(const CommandTicket& ticket);
+		static void endCommandBuffer(CommandBuffer& commandBuffer); //submit & wait
 
 		void allocateGraphicsCommandBuffer(VkCommandBuffer* commandBuffers, uint count);
 		void allocateTransferCommandBuffer(VkCommandBuffer* commandBuffers, uint count);
@@ -32,10 +26,6 @@ namespace Comphi::Vulkan {
 		VkCommandPool transferCommandPool;
 
 		void cleanUp(); //When a pool is destroyed, all command buffers allocated from the pool are freed.
-		
-	protected:
-		static VkCommandPool getCommandPool(CommandQueueOperation& op);
-		static VkQueue getCommandQueue(CommandQueueOperation& op);
 	};
 
 }
@@ -0,0 +1,103 @@
+#include "cphipch.h"
+#include "ThreadCommandPools.h"
+#include "Comphi/Core/ThreadPool.h"
+
+namespace Comphi::Vulkan {
+
+	ThreadCommandPools::ThreadCommandPools(uint frameCount, uint threadCount)
+	{
+		framePools = std::vector<std::vector<ThreadPoolData>>(frameCount, std::vector<ThreadPoolData>(threadCount));
+
+		for (auto& threadPools : framePools)
+		{
+			for (auto& threadPool : threadPools)
+			{
+				VkCommandPoolCreateInfo poolInfo{};
+				poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+				poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT; //reset as a whole every frame
+				poolInfo.queueFamilyIndex = GraphicsHandler::get()->graphicsQueueFamily.index;
+
+				vkCheckError(vkCreateCommandPool(GraphicsHandler::get()->logicalDevice, &poolInfo, nullptr, &threadPool.commandPool)) {
+					COMPHILOG_CORE_FATAL("failed to create thread command pool!");
+					throw std::runtime_error("failed to create thread command pool!");
+				}
+			}
+		}
+
+		COMPHILOG_CORE_INFO("created {0} command pools per frame in flight for command recording", threadCount);
+	}
+
+	void ThreadCommandPools::beginFrame(uint frame)
+	{
+		currentFrame = frame;
+		for (auto& threadPool : framePools[frame])
+		{
+			if (threadPool.usedSecondaryCommandBuffers == 0) continue;
+			vkResetCommandPool(GraphicsHandler::get()->logicalDevice, threadPool.commandPool, 0);
+			threadPool.usedSecondaryCommandBuffers = 0;
+		}
+	}
+
+	VkCommandBuffer ThreadCommandPools::beginSecondaryCommandBuffer(VkRenderPass renderPass, VkFramebuffer framebuffer)
+	{
+		ThreadPoolData& threadPool = framePools[currentFrame][ThreadPool::getThreadIndex()];
+
+		//command buffers are kept allocated and reused after the pool reset
+		if (threadPool.usedSecondaryCommandBuffers == threadPool.secondaryCommandBuffers.size())
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = threadPool.commandPool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer;
+			vkCheckError(vkAllocateCommandBuffers(GraphicsHandler::get()->logicalDevice, &allocInfo, &commandBuffer)) {
+				COMPHILOG_CORE_FATAL("failed to allocate secondary command buffer!");
+				throw std::runtime_error("failed to allocate secondary command buffer!");
+			}
+			threadPool.secondaryCommandBuffers.push_back(commandBuffer);
+		}
+		VkCommandBuffer commandBuffer = threadPool.secondaryCommandBuffers[threadPool.usedSecondaryCommandBuffers++];
+
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = renderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = framebuffer;
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		vkCheckError(vkBeginCommandBuffer(commandBuffer, &beginInfo)) {
+			COMPHILOG_CORE_FATAL("failed to begin recording secondary command buffer!");
+			throw std::runtime_error("failed to begin recording secondary command buffer!");
+		}
+		return commandBuffer;
+	}
+
+	void ThreadCommandPools::endSecondaryCommandBuffer(VkCommandBuffer commandBuffer)
+	{
+		vkCheckError(vkEndCommandBuffer(commandBuffer)) {
+			COMPHILOG_CORE_FATAL("failed to record secondary command buffer!");
+			throw std::runtime_error("failed to record secondary command buffer!");
+		}
+	}
+
+	void ThreadCommandPools::cleanUp()
+	{
+		for (auto& threadPools : framePools)
+		{
+			for (auto& threadPool : threadPools)
+			{
+				vkDestroyCommandPool(GraphicsHandler::get()->logicalDevice, threadPool.commandPool, nullptr);
+				threadPool.secondaryCommandBuffers.clear();
+			}
+		}
+		COMPHILOG_CORE_INFO("vkDestroy Destroy thread command pools");
+		framePools.clear();
+	}
+
+}
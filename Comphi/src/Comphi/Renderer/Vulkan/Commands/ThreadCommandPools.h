@@ -0,0 +1,34 @@
+#pragma once
+#include "Comphi/Renderer/Vulkan/GraphicsHandler.h"
+
+namespace Comphi::Vulkan {
+
+	//Graphics command pools per thread (ThreadPool index) and per frame in flight
+	//Command pools are externally synchronized, so each thread records from its own pool
+	//and a frame's pools are reset wholesale once its fence was waited on
+	class ThreadCommandPools
+	{
+	public:
+		ThreadCommandPools(uint frameCount, uint threadCount);
+
+		//resets every pool of frame (all its command buffers go back to the initial state)
+		void beginFrame(uint frame);
+
+		//secondary command buffer from the calling thread's pool, begun inside renderPass/subpass 0
+		VkCommandBuffer beginSecondaryCommandBuffer(VkRenderPass renderPass, VkFramebuffer framebuffer);
+		void endSecondaryCommandBuffer(VkCommandBuffer commandBuffer);
+
+		void cleanUp();
+
+	private:
+		struct ThreadPoolData {
+			VkCommandPool commandPool;
+			std::vector<VkCommandBuffer> secondaryCommandBuffers;
+			uint usedSecondaryCommandBuffers = 0;
+		};
+
+		std::vector<std::vector<ThreadPoolData>> framePools; //[frame][thread]
+		uint currentFrame = 0;
+	};
+
+}
@@ -0,0 +1,203 @@
+#include "cphipch.h"
+#include "TransientCommandPools.h"
+#include "Comphi/Core/ThreadPool.h"
+
+namespace Comphi::Vulkan {
+
+	TransientCommandPools* TransientCommandPools::get()
+	{
+		static TransientCommandPools transientCommandPools;
+		return &transientCommandPools;
+	}
+
+	TransientCommandPools::TransientCommandPools()
+	{
+		//main thread + workers, pools are created on first use
+		threadCount = ThreadPool::get()->getThreadCount() + 1;
+		contexts.resize(2 * threadCount);
+		for (auto& context : contexts) {
+			context = std::make_unique<ThreadCommandContext>();
+		}
+	}
+
+	TransientCommandPools::ThreadCommandContext& TransientCommandPools::getContext(CommandQueueOperation op, uint thread)
+	{
+		return *contexts[op * threadCount + thread];
+	}
+
+	VkQueue TransientCommandPools::getQueue(CommandQueueOperation op)
+	{
+		return op == TransferCommand ? GraphicsHandler::get()->transferQueueFamily.queue : GraphicsHandler::get()->graphicsQueueFamily.queue;
+	}
+
+	uint32_t TransientCommandPools::getQueueFamily(CommandQueueOperation op)
+	{
+		return op == TransferCommand ? GraphicsHandler::get()->transferQueueFamily.index : GraphicsHandler::get()->graphicsQueueFamily.index;
+	}
+
+	void TransientCommandPools::recycle(ThreadCommandContext& context)
+	{
+		//signaled fences stay signaled until the buffer is submitted again
+		for (uint slot = 0; slot < context.commandBuffers.size(); slot++)
+		{
+			TransientCommandBuffer& transient = context.commandBuffers[slot];
+			if (transient.inFlight && vkGetFenceStatus(GraphicsHandler::get()->logicalDevice, transient.fence) == VK_SUCCESS) {
+				transient.inFlight = false;
+				context.freeSlots.push_back(slot);
+			}
+		}
+	}
+
+	CommandBuffer TransientCommandPools::begin(CommandQueueOperation op)
+	{
+		CommandBuffer commandBuffer = { op };
+		commandBuffer.thread = ThreadPool::get()->getThreadIndex();
+		ThreadCommandContext& context = getContext(op, commandBuffer.thread);
+		std::lock_guard<std::mutex> lock(context.contextMutex);
+		VkDevice device = GraphicsHandler::get()->logicalDevice;
+
+		if (context.commandPool == VK_NULL_HANDLE) {
+			VkCommandPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+			poolInfo.queueFamilyIndex = getQueueFamily(op);
+
+			vkCheckError(vkCreateCommandPool(device, &poolInfo, nullptr, &context.commandPool)) {
+				COMPHILOG_CORE_FATAL("failed to create transient command pool!");
+				throw std::runtime_error("failed to create transient command pool!");
+			}
+		}
+
+		if (context.freeSlots.empty()) recycle(context);
+
+		if (context.freeSlots.empty()) {
+			TransientCommandBuffer transient;
+
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandPool = context.commandPool;
+			allocInfo.commandBufferCount = 1;
+			vkCheckError(vkAllocateCommandBuffers(device, &allocInfo, &transient.commandBuffer)) {
+				COMPHILOG_CORE_FATAL("failed to allocate transient command buffer!");
+				throw std::runtime_error("failed to allocate transient command buffer!");
+			}
+
+			//created signaled : a free buffer always has a signaled fence
+			VkFenceCreateInfo fenceInfo{};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+			vkCheckError(vkCreateFence(device, &fenceInfo, nullptr, &transient.fence)) {
+				COMPHILOG_CORE_FATAL("failed to create transient command fence!");
+				throw std::runtime_error("failed to create transient command fence!");
+			}
+
+			context.freeSlots.push_back((uint)context.commandBuffers.size());
+			context.commandBuffers.push_back(transient);
+		}
+
+		commandBuffer.slot = context.freeSlots.back();
+		context.freeSlots.pop_back();
+		commandBuffer.buffer = context.commandBuffers[commandBuffer.slot].commandBuffer;
+
+		//begin implicitly resets the buffer (RESET_COMMAND_BUFFER pool)
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(commandBuffer.buffer, &beginInfo);
+
+		return commandBuffer;
+	}
+
+	CommandTicket TransientCommandPools::submit(CommandBuffer& commandBuffer)
+	{
+		ThreadCommandContext& context = getContext(commandBuffer.op, commandBuffer.thread);
+		std::lock_guard<std::mutex> lock(context.contextMutex);
+		TransientCommandBuffer& transient = context.commandBuffers[commandBuffer.slot];
+
+		vkEndCommandBuffer(commandBuffer.buffer);
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer.buffer;
+		if (commandBuffer.waitSemaphore != nullptr) {
+			submitInfo.waitSemaphoreCount = 1;
+			submitInfo.pWaitSemaphores = commandBuffer.waitSemaphore;
+			submitInfo.pWaitDstStageMask = commandBuffer.waitDstStageMask;
+		}
+		if (commandBuffer.signalSemaphore != nullptr) {
+			submitInfo.signalSemaphoreCount = 1;
+			submitInfo.pSignalSemaphores = commandBuffer.signalSemaphore;
+		}
+
+		vkResetFences(GraphicsHandler::get()->logicalDevice, 1, &transient.fence);
+		{
+			VkQueue queue = getQueue(commandBuffer.op);
+			std::lock_guard<std::mutex> queueLock(GraphicsHandler::get()->getQueueMutex(queue));
+			vkCheckError(vkQueueSubmit(queue, 1, &submitInfo, transient.fence)) {
+				COMPHILOG_CORE_FATAL("failed to submit transient command buffer!");
+				throw std::runtime_error("failed to submit transient command buffer!");
+			}
+		}
+
+		transient.inFlight = true;
+		transient.submission++;
+
+		CommandTicket ticket;
+		ticket.op = commandBuffer.op;
+		ticket.thread = commandBuffer.thread;
+		ticket.slot = commandBuffer.slot;
+		ticket.submission = transient.submission;
+		return ticket;
+	}
+
+	bool TransientCommandPools::isComplete(const CommandTicket& ticket)
+	{
+		if (!ticket.isValid()) return true;
+
+		ThreadCommandContext& context = getContext(ticket.op, ticket.thread);
+		std::lock_guard<std::mutex> lock(context.contextMutex);
+		const TransientCommandBuffer& transient = context.commandBuffers[ticket.slot];
+		if (transient.submission != ticket.submission) return true; //recycled, so it was complete
+		return vkGetFenceStatus(GraphicsHandler::get()->logicalDevice, transient.fence) == VK_SUCCESS;
+	}
+
+	void TransientCommandPools::wait(const CommandTicket& ticket)
+	{
+		if (!ticket.isValid()) return;
+
+		VkFence fence;
+		{
+			ThreadCommandContext& context = getContext(ticket.op, ticket.thread);
+			std::lock_guard<std::mutex> lock(context.contextMutex);
+			const TransientCommandBuffer& transient = context.commandBuffers[ticket.slot];
+			if (transient.submission != ticket.submission) return;
+			fence = transient.fence;
+		}
+		//not waited under the lock, the owner thread keeps recording meanwhile
+		vkWaitForFences(GraphicsHandler::get()->logicalDevice, 1, &fence, VK_TRUE, UINT64_MAX);
+	}
+
+	void TransientCommandPools::cleanUp()
+	{
+		VkDevice device = GraphicsHandler::get()->logicalDevice;
+		for (auto& context : contexts)
+		{
+			std::lock_guard<std::mutex> lock(context->contextMutex);
+			if (context->commandPool == VK_NULL_HANDLE) continue;
+
+			for (auto& transient : context->commandBuffers) {
+				vkWaitForFences(device, 1, &transient.fence, VK_TRUE, UINT64_MAX);
+				vkDestroyFence(device, transient.fence, nullptr);
+			}
+			context->commandBuffers.clear();
+			context->freeSlots.clear();
+
+			COMPHILOG_CORE_INFO("vkDestroy Destroy transient command pool");
+			vkDestroyCommandPool(device, context->commandPool, nullptr);
+			context->commandPool = VK_NULL_HANDLE;
+		}
+	}
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "Comphi/Renderer/Vulkan/GraphicsHandler.h"
+#include <mutex>
+
+namespace Comphi::Vulkan {
+
+	enum CommandQueueOperation { TransferCommand, GraphicsCommand };
+
+	struct CommandBuffer {
+		CommandQueueOperation op;
+		VkCommandBuffer buffer;
+		VkSemaphore* signalSemaphore;
+		VkSemaphore* waitSemaphore;
+		VkPipelineStageFlags* waitDstStageMask;
+		uint thread; //recording thread & slot in its TransientCommandPools context
+		uint slot;
+	};
+
+	//Handle to a submitted one-shot command buffer, complete once its fence signaled
+	struct CommandTicket {
+		CommandQueueOperation op = GraphicsCommand;
+		uint thread = 0;
+		uint slot = UINT32_MAX;
+		uint64_t submission = 0;
+
+		inline bool isValid() const { return slot != UINT32_MAX; }
+	};
+
+	//Recycled one-shot command buffers per queue and per thread (ThreadPool index), each paired with a fence
+	//A buffer goes back to its thread's free list once its fence signaled, nothing is freed until cleanUp
+	class TransientCommandPools
+	{
+	public:
+		static TransientCommandPools* get();
+
+		//begun with ONE_TIME_SUBMIT from the calling thread's pool
+		CommandBuffer begin(CommandQueueOperation op);
+		//ends & submits with the paired fence (+ the optional semaphores), doesn't wait
+		CommandTicket submit(CommandBuffer& commandBuffer);
+
+		bool isComplete(const CommandTicket& ticket);
+		void wait(const CommandTicket& ticket);
+
+		void cleanUp();
+
+	private:
+		TransientCommandPools();
+
+		struct TransientCommandBuffer {
+			VkCommandBuffer commandBuffer;
+			VkFence fence;
+			uint64_t submission = 0; //incremented on every submit, older tickets are complete
+			bool inFlight = false;
+		};
+
+		struct ThreadCommandContext {
+			std::mutex contextMutex; //uncontended, the owner thread vs ticket queries from other threads
+			VkCommandPool commandPool = VK_NULL_HANDLE;
+			std::vector<TransientCommandBuffer> commandBuffers;
+			std::vector<uint> freeSlots;
+		};
+
+		ThreadCommandContext& getContext(CommandQueueOperation op, uint thread);
+		VkQueue getQueue(CommandQueueOperation op);
+		uint32_t getQueueFamily(CommandQueueOperation op);
+		void recycle(ThreadCommandContext& context);
+
+		uint threadCount;
+		std::vector<std::unique_ptr<ThreadCommandContext>> contexts; //[op * threadCount + thread]
+	};
+
+}
@@ -0,0 +1,157 @@
+#include "cphipch.h"
+#include "DescriptorAllocator.h"
+
+namespace Comphi::Vulkan {
+
+	template<typename T>
+	static inline void appendKey(std::string& key, const T& value) {
+		static_assert(std::is_trivially_copyable_v<T>);
+		key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	DescriptorAllocator::DescriptorAllocator(uint frameCount)
+	{
+		frames = std::vector<FramePools>(frameCount);
+		currentFrame = &frames[0];
+	}
+
+	void DescriptorAllocator::beginFrame(uint frame)
+	{
+		frameCounter++;
+		currentFrame = &frames[frame];
+
+		//stale sets (scene changed since this frame was recorded) -> start over from empty pools
+		for (auto& cachedSet : currentFrame->cache) {
+			if (cachedSet.second.lastUsedFrame < currentFrame->lastBeginFrame) {
+				resetFrame(*currentFrame);
+				break;
+			}
+		}
+		currentFrame->lastBeginFrame = frameCounter;
+	}
+
+	void DescriptorAllocator::resetFrame(FramePools& frame)
+	{
+		for (auto& pool : frame.pools) {
+			vkResetDescriptorPool(GraphicsHandler::get()->logicalDevice, pool, 0);
+		}
+		frame.activePool = 0;
+		frame.cache.clear();
+	}
+
+	VkDescriptorSet DescriptorAllocator::getDescriptorSet(VkDescriptorSetLayout layout, const std::string& resourceKey, bool& isNewSet)
+	{
+		auto cachedSet = currentFrame->cache.find(resourceKey);
+		if (cachedSet != currentFrame->cache.end()) {
+			cachedSet->second.lastUsedFrame = frameCounter;
+			isNewSet = false;
+			return cachedSet->second.descriptorSet;
+		}
+
+		isNewSet = true;
+		VkDescriptorSet descriptorSet = allocate(layout);
+		currentFrame->cache[resourceKey] = { descriptorSet, frameCounter };
+		return descriptorSet;
+	}
+
+	VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout)
+	{
+		FramePools& frame = *currentFrame;
+
+		while (true) {
+			bool freshPool = frame.activePool == frame.pools.size();
+			if (freshPool) {
+				frame.pools.push_back(createPool());
+			}
+
+			VkDescriptorSetAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			allocInfo.descriptorSetCount = 1;
+			allocInfo.descriptorPool = frame.pools[frame.activePool];
+			allocInfo.pSetLayouts = &layout;
+
+			VkDescriptorSet descriptorSet;
+			VkResult result = vkAllocateDescriptorSets(GraphicsHandler::get()->logicalDevice, &allocInfo, &descriptorSet);
+			if (result == VK_SUCCESS) return descriptorSet;
+
+			if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) {
+				COMPHILOG_CORE_FATAL("failed to allocate descriptor sets!");
+				throw std::runtime_error("failed to allocate descriptor sets!");
+			}
+
+			//an empty pool can't hold the layout, more pools wouldn't either
+			if (freshPool) {
+				COMPHILOG_CORE_ERROR("failed to allocate a descriptor set from an empty pool, the layout exceeds the pool sizes!");
+				throw std::runtime_error("failed to allocate a descriptor set from an empty pool!");
+			}
+
+			//pool full, move on to the next one
+			frame.activePool++;
+		}
+	}
+
+	VkDescriptorPool DescriptorAllocator::createPool()
+	{
+		std::vector<VkDescriptorPoolSize> poolSizes = {
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4 * SetsPerPool },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2 * SetsPerPool },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 2 * SetsPerPool },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 * SetsPerPool },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 2 * SetsPerPool }
+		};
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = poolSizes.size();
+		poolInfo.pPoolSizes = poolSizes.data();
+		poolInfo.maxSets = SetsPerPool;
+
+		VkDescriptorPool pool;
+		vkCheckError(vkCreateDescriptorPool(GraphicsHandler::get()->logicalDevice, &poolInfo, nullptr, &pool)) {
+			COMPHILOG_CORE_FATAL("failed to create descriptor pool!");
+			throw std::runtime_error("failed to create descriptor pool!");
+		}
+		return pool;
+	}
+
+	std::string DescriptorAllocator::getDescriptorWritesKey(VkDescriptorSetLayout layout, const std::vector<VkWriteDescriptorSet>& descriptorWrites)
+	{
+		std::string key;
+		appendKey(key, layout);
+		for (auto& write : descriptorWrites)
+		{
+			appendKey(key, write.dstBinding);
+			appendKey(key, write.dstArrayElement);
+			appendKey(key, write.descriptorType);
+			appendKey(key, write.descriptorCount);
+			for (uint i = 0; i < write.descriptorCount; i++)
+			{
+				if (write.pBufferInfo != nullptr) {
+					appendKey(key, write.pBufferInfo[i].buffer);
+					appendKey(key, write.pBufferInfo[i].offset);
+					appendKey(key, write.pBufferInfo[i].range);
+				}
+				if (write.pImageInfo != nullptr) {
+					appendKey(key, write.pImageInfo[i].imageView);
+					appendKey(key, write.pImageInfo[i].sampler);
+					appendKey(key, write.pImageInfo[i].imageLayout);
+				}
+			}
+		}
+		return key;
+	}
+
+	void DescriptorAllocator::cleanUp()
+	{
+		for (auto& frame : frames)
+		{
+			for (auto& pool : frame.pools) {
+				COMPHILOG_CORE_INFO("vkDestroy Destroy descriptorPool");
+				vkDestroyDescriptorPool(GraphicsHandler::get()->logicalDevice, pool, nullptr);
+			}
+			frame.pools.clear();
+			frame.cache.clear();
+		}
+	}
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "Comphi/Renderer/Vulkan/GraphicsHandler.h"
+
+namespace Comphi::Vulkan {
+
+	//Descriptor sets allocated from per frame in flight pools + a cache keyed by the bound resources
+	//A set found in the cache is reused as is (never rewritten), so sets are never updated while in use
+	//When a frame's cache holds sets that weren't used during its last recording its pools are reset wholesale
+	class DescriptorAllocator
+	{
+	public:
+		static constexpr uint SetsPerPool = 256;
+
+		DescriptorAllocator(uint frameCount);
+
+		//call after the fence of frame was waited on
+		void beginFrame(uint frame);
+
+		//returns a cached set for resourceKey or allocates a new one (isNewSet = true, caller writes it)
+		VkDescriptorSet getDescriptorSet(VkDescriptorSetLayout layout, const std::string& resourceKey, bool& isNewSet);
+		VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+
+		//the layout + binding, type & every resource (handles, ranges, layouts) referenced by the writes
+		//compared as a whole on lookup, hash collisions can't hand out a set bound to other resources
+		static std::string getDescriptorWritesKey(VkDescriptorSetLayout layout, const std::vector<VkWriteDescriptorSet>& descriptorWrites);
+
+		void cleanUp();
+
+	private:
+		struct CachedSet {
+			VkDescriptorSet descriptorSet;
+			uint64_t lastUsedFrame;
+		};
+
+		struct FramePools {
+			std::vector<VkDescriptorPool> pools;
+			uint activePool = 0;
+			std::unordered_map<std::string, CachedSet> cache;
+			uint64_t lastBeginFrame = 0;
+		};
+
+		VkDescriptorPool createPool();
+		void resetFrame(FramePools& frame);
+
+		std::vector<FramePools> frames;
+		FramePools* currentFrame = nullptr;
+		uint64_t frameCounter = 0;
+	};
+
+}
@@ -1,9 +1,12 @@
 #include "cphipch.h"
 #include "GraphicsPipeline.h"
 #include "Comphi/Renderer/Vulkan/Graphics/ShaderProgram.h"
+#include "Comphi/Renderer/Vulkan/Memory/DeferredDeletionQueue.h"
 	
 namespace Comphi::Vulkan {
 
+	std::atomic<uint64_t> GraphicsPipeline::nextCreationIndex = 0;
+
 	void GraphicsPipeline::initialize() 
 	{
 		//TODO: Move all this code to separate Functions
@@ -185,15 +188,11 @@ namespace Comphi::Vulkan {
 		//How many Descriptor Sets per PipelineLayoutSet ?
 		//TODO: Test if we can have N DescriptorSetLayouts and One DescriptorPool per descriptorSet Layout
 
-		//Dynamic DescriptorSetLayout & Pool Creation !
-		size_t MAX_FRAMES_IN_FLIGHT = static_cast<uint>(*GraphicsHandler::get()->MAX_FRAMES_IN_FLIGHT); //TODO: Validate this with some tests
-		
+		//Dynamic DescriptorSetLayout Creation ! (sets are allocated per frame by the DescriptorAllocator)
 		size_t layoutSetsCount = configuration.pipelineLayoutConfiguration.layoutSets.size();
 		pipelineLayoutsSets = std::vector<LayoutSet>(layoutSetsCount);
 		auto descriptorSetLayouts = std::vector<VkDescriptorSetLayout>(layoutSetsCount);
 
-		std::vector<VkDescriptorPoolSize> poolSizes;
-		uint poolSizesMaxSets = 0;
 		for (size_t i = 0; i < layoutSetsCount; i++)
 		{
 			pipelineLayoutsSets[i].descriptorSetBindingsCount = configuration.pipelineLayoutConfiguration.layoutSets[i].shaderResourceDescriptorSetBindings.size();
@@ -211,13 +210,6 @@ namespace Comphi::Vulkan {
 				descriptorSetBindings[n].stageFlags = (VkShaderStageFlags)descriptorSet.shaderStage;
 				descriptorSetBindings[n].pImmutableSamplers = nullptr; // Optional : relevant for image sampling
 
-				//Descriptor Pool Allocation data
-				VkDescriptorPoolSize descriptorPoolSize;
-				descriptorPoolSize.type = (VkDescriptorType)descriptorSet.resourceType;
-				descriptorPoolSize.descriptorCount = descriptorSet.resourceCount * MAX_FRAMES_IN_FLIGHT;
-				poolSizes.push_back(descriptorPoolSize);
-				poolSizesMaxSets += descriptorPoolSize.descriptorCount;
-
 				COMPHILOG_CORE_INFO("created descriptorSet {0} !", n);
 
 			}
@@ -255,8 +247,14 @@ namespace Comphi::Vulkan {
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipelineLayoutInfo.setLayoutCount = layoutSetsCount; //Descriptor set ID count
 		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data(); //Descriptor set IDs ptr (layout(set = #))
-		pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-		pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
+		//Push Constants
+		std::vector<VkPushConstantRange> pushConstantRanges;
+		for (auto& range : configuration.pipelineLayoutConfiguration.getLayoutPushConstantRanges()) {
+			pushConstantRanges.push_back({ (VkShaderStageFlags)range.shaderStage, range.offset, range.size });
+		}
+		pushConstantUpdates = createPushConstantUpdates(pushConstantRanges);
+		pipelineLayoutInfo.pushConstantRangeCount = pushConstantRanges.size();
+		pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.empty() ? nullptr : pushConstantRanges.data();
 
 		vkCheckError(vkCreatePipelineLayout(GraphicsHandler::get()->logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout)) {
 			COMPHILOG_CORE_FATAL("failed to create pipeline layout!");
@@ -265,44 +263,36 @@ namespace Comphi::Vulkan {
 
 		COMPHILOG_CORE_INFO("created pipelineLayout successfully!");
 
-		//Allocate DescriptorsPool 
-		VkDescriptorPoolCreateInfo poolInfo{};
-		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		poolInfo.poolSizeCount = poolSizes.size();
-		poolInfo.pPoolSizes = poolSizes.data();
-		poolInfo.maxSets = poolSizesMaxSets;
-
-		vkCheckError(vkCreateDescriptorPool(GraphicsHandler::get()->logicalDevice, &poolInfo, nullptr, &pipelineDescriptorPool)) {
-			COMPHILOG_CORE_FATAL("failed to create descriptor pool!");
-			throw std::runtime_error("failed to create descriptor pool!");
-		};
-
-		COMPHILOG_CORE_INFO("allocated Material DescriptorPool successfully!");
-
-		//Allocate DescriptorSets
-		for (size_t i = 0; i < layoutSetsCount; i++)
-		{
-			if (pipelineLayoutsSets[i].descriptorSetBindingsCount == 0) continue; //skip dummies
-			
-			VkDescriptorSetAllocateInfo allocInfo{};
-			allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-			allocInfo.descriptorSetCount = 1;
-			allocInfo.descriptorPool = pipelineDescriptorPool;
-			allocInfo.pSetLayouts = &pipelineLayoutsSets[i].descriptorSetLayout;
-			vkCheckError(vkAllocateDescriptorSets(GraphicsHandler::get()->logicalDevice, &allocInfo, &pipelineLayoutsSets[i].descriptorSet)) {
-				COMPHILOG_CORE_FATAL("failed to allocate descriptor sets!");
-				return;
-			}
-			COMPHILOG_CORE_INFO("allocated DescriptorSets of Layout {0} successfully!", i);
-
-		}
-
 		size_t stageCount = configuration.pipelineLayoutConfiguration.shaderPrograms.size();
 		std::vector<VkPipelineShaderStageCreateInfo> shaderStagesInfo = std::vector<VkPipelineShaderStageCreateInfo>(stageCount);
+
+		//Specialization constants (kept alive until vkCreateGraphicsPipelines)
+		std::vector<std::vector<VkSpecializationMapEntry>> specializationEntries = std::vector<std::vector<VkSpecializationMapEntry>>(stageCount);
+		std::vector<std::vector<uint8_t>> specializationData = std::vector<std::vector<uint8_t>>(stageCount);
+		std::vector<VkSpecializationInfo> specializationInfos = std::vector<VkSpecializationInfo>(stageCount);
+
 		for (size_t i = 0; i < stageCount; i++)
 		{
 			ShaderProgram* _shaderProgram = static_cast<ShaderProgram*>(configuration.pipelineLayoutConfiguration.shaderPrograms[i]);
 
+			for (const auto& [constantID, value] : configuration.getSpecializationConstants(_shaderProgram))
+			{
+				//bool constants are VkBool32 in SPIR-V, every type is 4 bytes
+				uint32_t rawValue = std::visit([](auto v) -> uint32_t {
+					if constexpr (std::is_same_v<decltype(v), bool>) return v ? VK_TRUE : VK_FALSE;
+					else { uint32_t raw; memcpy(&raw, &v, sizeof(raw)); return raw; }
+				}, value);
+
+				specializationEntries[i].push_back({ constantID, (uint32_t)specializationData[i].size(), sizeof(uint32_t) });
+				specializationData[i].insert(specializationData[i].end(), (uint8_t*)&rawValue, (uint8_t*)&rawValue + sizeof(uint32_t));
+			}
+
+			specializationInfos[i].mapEntryCount = (uint32_t)specializationEntries[i].size();
+			specializationInfos[i].pMapEntries = specializationEntries[i].data();
+			specializationInfos[i].dataSize = specializationData[i].size();
+			specializationInfos[i].pData = specializationData[i].data();
+			shaderStagesInfo[i].pSpecializationInfo = specializationEntries[i].empty() ? nullptr : &specializationInfos[i];
+
 			switch (_shaderProgram->GetType())
 			{
 			case (uint)Comphi::ShaderType::VertexShader: {
@@ -311,7 +301,6 @@ namespace Comphi::Vulkan {
 				shaderStagesInfo[i].stage = VK_SHADER_STAGE_VERTEX_BIT;
 				shaderStagesInfo[i].module = _shaderProgram->shaderModule;
 				shaderStagesInfo[i].pName = _shaderProgram->entryPointFunctionName.data();
-				shaderStagesInfo[i].pSpecializationInfo = nullptr;
 				break;
 			}
 			case (uint)Comphi::ShaderType::FragmentShader: {
@@ -351,7 +340,8 @@ namespace Comphi::Vulkan {
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
 		pipelineInfo.basePipelineIndex = -1; // Optional
 
-		vkCheckError(vkCreateGraphicsPipelines(GraphicsHandler::get()->logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipelineObj)) {
+		VkPipelineCache cache = pipelineCache != VK_NULL_HANDLE ? pipelineCache : GraphicsHandler::get()->pipelineCache;
+		vkCheckError(vkCreateGraphicsPipelines(GraphicsHandler::get()->logicalDevice, cache, 1, &pipelineInfo, nullptr, &pipelineObj)) {
 			COMPHILOG_CORE_FATAL("failed to create graphics pipeline!");
 			throw std::runtime_error("failed to create graphics layout!");
 		}
@@ -366,13 +356,15 @@ namespace Comphi::Vulkan {
 
 		VkWriteDescriptorSet descriptorWrite = {};
 		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrite.dstSet = pipelineLayoutsSets[setID].descriptorSet;
+		descriptorWrite.dstSet = VK_NULL_HANDLE;
 		descriptorWrite.dstBinding = descriptorID;
 		descriptorWrite.dstArrayElement = 0;
 
 		switch (descriptorSet.resourceType)
 		{
 		case DescriptorSetResourceType::UniformBufferData:
+		case DescriptorSetResourceType::StorageBufferData:
+		case DescriptorSetResourceType::UniformBufferDynamic:
 		case DescriptorSetResourceType::StorageBufferDynamic:
 		{
 			auto uniformBufferArr = static_cast<IUniformBuffer**>(dataObjectsArray);
@@ -416,9 +408,11 @@ namespace Comphi::Vulkan {
 			for (size_t i = 0; i < descriptorSet.resourceCount; i++)
 			{
 
+				//streamed textures are swapped in once resident (the descriptor hash changes with the view)
+				ImageView* texture = imageView[0]->getBoundTexture();
 				imageSamplers[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-				imageSamplers[i].imageView = imageView[0]->imageView;
-				imageSamplers[i].sampler = imageView[0]->textureSampler;
+				imageSamplers[i].imageView = texture->imageView;
+				imageSamplers[i].sampler = texture->textureSampler;
 			}
 
 			descriptorWrite.descriptorType = VkDescriptorType(descriptorSet.resourceType);;
@@ -438,43 +432,117 @@ namespace Comphi::Vulkan {
 		return descriptorWrite;
 	}
 
-	void Comphi::Vulkan::GraphicsPipeline::bindDescriptorSets(VkCommandBuffer& commandBuffer)
+	VkWriteDescriptorSet GraphicsPipeline::getDescriptorSetWrite(const VkDescriptorBufferInfo& bufferInfo, LayoutSetUpdateFrequency setID, uint descriptorID)
 	{
-		int firstSet = 1;
-		auto descriptorSets = std::vector<VkDescriptorSet>();
-		for (auto& set : pipelineLayoutsSets)
+		DescriptorSetBinding& descriptorSet = getDescriptorSet(setID, descriptorID);
+
+		VkWriteDescriptorSet descriptorWrite = {};
+		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrite.dstSet = VK_NULL_HANDLE;
+		descriptorWrite.dstBinding = descriptorID;
+		descriptorWrite.dstArrayElement = 0;
+		descriptorWrite.descriptorType = VkDescriptorType(descriptorSet.resourceType);
+		descriptorWrite.descriptorCount = 1;
+		descriptorWrite.pBufferInfo = new VkDescriptorBufferInfo(bufferInfo);
+
+		return descriptorWrite;
+	}
+
+	void Comphi::Vulkan::GraphicsPipeline::bindDescriptorSet(VkCommandBuffer& commandBuffer, LayoutSetUpdateFrequency setID, VkDescriptorSet descriptorSet, const std::vector<uint32_t>& dynamicOffsets)
+	{
+		uint32_t dynamicDescriptors = dynamicOffsets.size();
+		const uint32_t* dynamicStartOffsets = dynamicOffsets.empty() ? NULL : dynamicOffsets.data();
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, setID, 1, &descriptorSet, dynamicDescriptors, dynamicStartOffsets);
+	}
+
+	void GraphicsPipeline::pushConstants(VkCommandBuffer& commandBuffer, uint offset, uint size, const void* data)
+	{
+		//split on the layout pieces so every byte is pushed with the stages of the ranges covering it
+		for (auto& update : pushConstantUpdates)
 		{
-			if (set.descriptorSetBindingsCount == 0) {
-				firstSet++;
+			uint begin = (std::max)(offset, update.offset);
+			uint end = (std::min)(offset + size, update.offset + update.size);
+			if (begin >= end) continue;
+			vkCmdPushConstants(commandBuffer, pipelineLayout, update.stageFlags, begin, end - begin, static_cast<const char*>(data) + (begin - offset));
+		}
+	}
+
+	std::vector<VkPushConstantRange> GraphicsPipeline::createPushConstantUpdates(const std::vector<VkPushConstantRange>& layoutRanges)
+	{
+		//layout ranges of different stages may overlap : split at every range boundary,
+		//each piece is pushed with the stages of every range covering it
+		std::set<uint> boundaries;
+		for (auto& range : layoutRanges) {
+			boundaries.insert(range.offset);
+			boundaries.insert(range.offset + range.size);
+		}
+
+		std::vector<VkPushConstantRange> updates;
+		for (auto it = boundaries.begin(); it != boundaries.end() && std::next(it) != boundaries.end(); it++) {
+			uint begin = *it;
+			uint end = *std::next(it);
+			VkShaderStageFlags stageFlags = 0;
+			for (auto& range : layoutRanges) {
+				if (range.offset <= begin && end <= range.offset + range.size) stageFlags |= range.stageFlags;
+			}
+			if (stageFlags == 0) continue;
+
+			if (!updates.empty() && updates.back().stageFlags == stageFlags && updates.back().offset + updates.back().size == begin) {
+				updates.back().size += end - begin;
 				continue;
-			};
-			descriptorSets.push_back(set.descriptorSet);
+			}
+			updates.push_back({ stageFlags, begin, end - begin });
 		}
+		return updates;
+	}
 
-		uint32_t dynamicDescriptors = 0; //1
-		uint32_t* dynamicStorageStartOffsets = NULL;// {0};
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 2, 1, descriptorSets.data(), dynamicDescriptors, dynamicStorageStartOffsets);
+	std::vector<uint32_t> GraphicsPipeline::createDynamicOffsets(LayoutSetUpdateFrequency setID)
+	{
+		uint bindingsCount = configuration.pipelineLayoutConfiguration.layoutSets[setID].shaderResourceDescriptorSetBindings.size();
+		return std::vector<uint32_t>(getDynamicOffsetIndex(setID, bindingsCount), 0);
+	}
 
+	uint GraphicsPipeline::getDynamicOffsetIndex(LayoutSetUpdateFrequency setID, uint descriptorID)
+	{
+		//dynamic offsets are consumed in binding order, arrays take one offset per element
+		uint offsetIndex = 0;
+		for (uint i = 0; i < descriptorID; i++)
+		{
+			DescriptorSetBinding& descriptorSet = getDescriptorSet(setID, i);
+			if (isDynamicDescriptor(descriptorSet.resourceType)) {
+				offsetIndex += descriptorSet.resourceCount;
+			}
+		}
+		return offsetIndex;
 	}
 
 	void GraphicsPipeline::cleanUp()
 	{
+		//background compilation still writing the handles
+		if (compilation.valid()) compilation.wait();
+
+		std::vector<VkDescriptorSetLayout> setLayouts;
 		for (size_t i = 0; i < pipelineLayoutsSets.size(); i++)
 		{
-			COMPHILOG_CORE_INFO("vkDestroy Destroy descriptorPool");
-			vkDestroyDescriptorPool(Vulkan::GraphicsHandler::get()->logicalDevice, pipelineDescriptorPool, nullptr);
-			pipelineLayoutsSets[i].descriptorSetBindings.clear(); //pipeline clears descriptor sets :3
-
-			COMPHILOG_CORE_INFO("vkDestroy Destroy descriptorSetLayout");
-			vkDestroyDescriptorSetLayout(Vulkan::GraphicsHandler::get()->logicalDevice, pipelineLayoutsSets[i].descriptorSetLayout, nullptr);
+			pipelineLayoutsSets[i].descriptorSetBindings.clear();
+			setLayouts.push_back(pipelineLayoutsSets[i].descriptorSetLayout);
 		}
 
-		COMPHILOG_CORE_INFO("vkDestroy Destroy PipelineLayout");
-		vkDestroyPipelineLayout(GraphicsHandler::get()->logicalDevice, pipelineLayout, nullptr);
+		//in flight frames may still be bound to the pipeline, destroyed once they retired
+		VkPipelineLayout layout = pipelineLayout;
+		VkPipeline pipeline = pipelineObj;
+		DeferredDeletionQueue::get()->enqueue([setLayouts, layout, pipeline]() {
+			for (VkDescriptorSetLayout setLayout : setLayouts) {
+				COMPHILOG_CORE_INFO("vkDestroy Destroy descriptorSetLayout");
+				vkDestroyDescriptorSetLayout(GraphicsHandler::get()->logicalDevice, setLayout, nullptr);
+			}
 
-		COMPHILOG_CORE_INFO("vkDestroy Destroy graphicsPipeline");
-		vkDestroyPipeline(GraphicsHandler::get()->logicalDevice, pipelineObj, nullptr);
+			COMPHILOG_CORE_INFO("vkDestroy Destroy PipelineLayout");
+			vkDestroyPipelineLayout(GraphicsHandler::get()->logicalDevice, layout, nullptr);
 
+			COMPHILOG_CORE_INFO("vkDestroy Destroy graphicsPipeline");
+			vkDestroyPipeline(GraphicsHandler::get()->logicalDevice, pipeline, nullptr);
+		});
 	}
 
 	//one Descriptor set per Frame in flight...
@@ -1,6 +1,7 @@
 #pragma once
 #include "Comphi/Renderer/IGraphicsPipeline.h"
 #include "Comphi/Renderer/Vulkan/Images/ImageView.h"
+#include <atomic>
 
 namespace Comphi::Vulkan {
 	
@@ -10,7 +11,6 @@ namespace Comphi::Vulkan {
 	
 	struct LayoutSet {
 		VkDescriptorSetLayout descriptorSetLayout;
-		VkDescriptorSet descriptorSet;
 		std::vector<VkDescriptorSetLayoutBinding> descriptorSetBindings;
 		uint descriptorSetBindingsCount;
 	};
@@ -18,18 +18,34 @@ namespace Comphi::Vulkan {
 	class GraphicsPipeline : public IGraphicsPipeline
 	{
 	public:
-		GraphicsPipeline() = default;
+		GraphicsPipeline() : creationIndex(nextCreationIndex++) {};
 		virtual void initialize() override;
 
+		//dstSet is left empty, descriptor sets come from the DescriptorAllocator
 		VkWriteDescriptorSet getDescriptorSetWrite(void* dataObjectsArray, LayoutSetUpdateFrequency setID, uint descriptorID);
-		void bindDescriptorSets(VkCommandBuffer& commandBuffer);
+		VkWriteDescriptorSet getDescriptorSetWrite(const VkDescriptorBufferInfo& bufferInfo, LayoutSetUpdateFrequency setID, uint descriptorID); //single buffer range (FrameRingBuffer allocations)
+		void bindDescriptorSet(VkCommandBuffer& commandBuffer, LayoutSetUpdateFrequency setID, VkDescriptorSet descriptorSet, const std::vector<uint32_t>& dynamicOffsets = {});
+
+		//writes [offset, offset + size) of the push constant ranges while recording, data is only read during the call
+		void pushConstants(VkCommandBuffer& commandBuffer, uint offset, uint size, const void* data);
+
+		//one offset per dynamic descriptor of the set, in binding order
+		std::vector<uint32_t> createDynamicOffsets(LayoutSetUpdateFrequency setID);
+		uint getDynamicOffsetIndex(LayoutSetUpdateFrequency setID, uint descriptorID);
+		inline bool isDynamicBinding(LayoutSetUpdateFrequency setID, uint descriptorID) { return isDynamicDescriptor(getDescriptorSet(setID, descriptorID).resourceType); }
+		inline VkDescriptorSetLayout getDescriptorSetLayout(LayoutSetUpdateFrequency setID) const { return pipelineLayoutsSets[setID].descriptorSetLayout; }
 		virtual void cleanUp() override;
 
-		VkPipeline pipelineObj;
+		VkPipeline pipelineObj = VK_NULL_HANDLE;
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE; //set before initialize() to compile with another cache than the GraphicsHandler's
+		uint64_t creationIndex; //stable order of the pipelines (batches are sorted by it), unlike their addresses
 	private:
-		VkPipelineLayout pipelineLayout;
+		static std::atomic<uint64_t> nextCreationIndex;
+		VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
 		std::vector<LayoutSet> pipelineLayoutsSets;
-		VkDescriptorPool pipelineDescriptorPool;
+		std::vector<VkPushConstantRange> pushConstantUpdates; //vkCmdPushConstants calls covering the layout ranges
+
+		static std::vector<VkPushConstantRange> createPushConstantUpdates(const std::vector<VkPushConstantRange>& layoutRanges);
 
 		inline DescriptorSetBinding& getDescriptorSet(uint setID, uint descriptorID) {
 			return configuration.pipelineLayoutConfiguration.layoutSets[setID].shaderResourceDescriptorSetBindings[descriptorID];
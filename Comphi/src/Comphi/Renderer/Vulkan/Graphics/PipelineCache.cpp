@@ -0,0 +1,119 @@
+#include "cphipch.h"
+#include "PipelineCache.h"
+#include <filesystem>
+
+namespace Comphi::Vulkan {
+
+	PipelineCache::PipelineCache(const std::string& filePath) : filePath(filePath)
+	{
+		std::vector<char> fileData;
+		std::ifstream ifs(filePath, std::ios::ate | std::ios::binary);
+		if (ifs.is_open()) {
+			fileData.resize((size_t)ifs.tellg());
+			ifs.seekg(0);
+			ifs.read(fileData.data(), fileData.size());
+			ifs.close();
+		}
+
+		if (fileData.empty()) {
+			COMPHILOG_CORE_INFO("no pipeline cache found at {0}, starting empty", filePath);
+		}
+		else if (!isCompatible(fileData, GraphicsHandler::get()->deviceProperties)) {
+			COMPHILOG_CORE_ERROR("pipeline cache {0} was created by another device or driver, starting empty", filePath);
+			fileData.clear();
+		}
+		else {
+			COMPHILOG_CORE_INFO("loaded pipeline cache {0} ({1} bytes)", filePath, fileData.size());
+			loadedFromDisk = true;
+		}
+
+		create(fileData);
+	}
+
+	PipelineCache::PipelineCache(const std::vector<char>& initialData)
+	{
+		create(initialData);
+	}
+
+	void PipelineCache::create(const std::vector<char>& initialData)
+	{
+		VkPipelineCacheCreateInfo cacheInfo{};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cacheInfo.initialDataSize = initialData.size();
+		cacheInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+		vkCheckError(vkCreatePipelineCache(GraphicsHandler::get()->logicalDevice, &cacheInfo, nullptr, &cacheObj)) {
+			COMPHILOG_CORE_FATAL("failed to create pipeline cache!");
+			throw std::runtime_error("failed to create pipeline cache!");
+		}
+	}
+
+	bool PipelineCache::isCompatible(const std::vector<char>& data, const VkPhysicalDeviceProperties& properties)
+	{
+		VkPipelineCacheHeaderVersionOne header;
+		if (data.size() < sizeof(header)) return false;
+		memcpy(&header, data.data(), sizeof(header));
+
+		return header.headerSize >= sizeof(header)
+			&& header.headerSize <= data.size()
+			&& header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+			&& header.vendorID == properties.vendorID
+			&& header.deviceID == properties.deviceID
+			&& memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
+	std::vector<char> PipelineCache::getData()
+	{
+		size_t dataSize = 0;
+		vkGetPipelineCacheData(GraphicsHandler::get()->logicalDevice, cacheObj, &dataSize, nullptr);
+
+		std::vector<char> data(dataSize);
+		vkCheckError(vkGetPipelineCacheData(GraphicsHandler::get()->logicalDevice, cacheObj, &dataSize, data.data())) {
+			COMPHILOG_CORE_ERROR("failed to read pipeline cache data!");
+			return {};
+		}
+		data.resize(dataSize);
+		return data;
+	}
+
+	void PipelineCache::save()
+	{
+		if (filePath.empty()) return;
+
+		std::vector<char> data = getData();
+		if (data.empty()) return;
+
+		//written next to the cache then renamed over it, a crash mid write never leaves a truncated cache
+		std::string tmpPath = filePath + ".tmp";
+		std::ofstream ofs(tmpPath, std::ios::binary | std::ios::trunc);
+		if (!ofs.is_open()) {
+			COMPHILOG_CORE_ERROR("failed to write pipeline cache {0}", tmpPath);
+			return;
+		}
+		ofs.write(data.data(), data.size());
+		ofs.close();
+
+		std::error_code error;
+		if (ofs.fail()) {
+			COMPHILOG_CORE_ERROR("failed to write pipeline cache {0}", tmpPath);
+			std::filesystem::remove(tmpPath, error);
+			return;
+		}
+
+		std::filesystem::rename(tmpPath, filePath, error); //replaces the previous cache
+		if (error) {
+			COMPHILOG_CORE_ERROR("failed to replace pipeline cache {0} : {1}", filePath, error.message());
+			std::filesystem::remove(tmpPath, error);
+			return;
+		}
+		COMPHILOG_CORE_INFO("saved pipeline cache {0} ({1} bytes)", filePath, data.size());
+	}
+
+	void PipelineCache::cleanUp()
+	{
+		COMPHILOG_CORE_INFO("vkDestroy Destroy pipeline cache");
+		vkDestroyPipelineCache(GraphicsHandler::get()->logicalDevice, cacheObj, nullptr);
+		cacheObj = VK_NULL_HANDLE;
+	}
+
+}
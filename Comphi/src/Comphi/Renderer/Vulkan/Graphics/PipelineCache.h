@@ -0,0 +1,30 @@
+#pragma once
+#include "Comphi/Renderer/Vulkan/GraphicsHandler.h"
+
+namespace Comphi::Vulkan {
+
+	//VkPipelineCache serialized to disk, compiled pipelines are reused across launches
+	//The file is only loaded when its header matches this device (vendor/device ID & cache UUID),
+	//otherwise the cache starts empty and the file is overwritten on save
+	class PipelineCache
+	{
+	public:
+		PipelineCache(const std::string& filePath);
+		PipelineCache(const std::vector<char>& initialData); //in memory only, save() does nothing
+
+		std::vector<char> getData();
+		void save();
+		void cleanUp();
+
+		//checks the VkPipelineCacheHeaderVersionOne at the start of data against the device properties
+		static bool isCompatible(const std::vector<char>& data, const VkPhysicalDeviceProperties& properties);
+
+		VkPipelineCache cacheObj = VK_NULL_HANDLE;
+		bool loadedFromDisk = false;
+
+	private:
+		void create(const std::vector<char>& initialData);
+		std::string filePath;
+	};
+
+}
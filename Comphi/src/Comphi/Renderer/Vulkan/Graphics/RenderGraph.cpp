@@ -0,0 +1,647 @@
+#include "cphipch.h"
+#include "RenderGraph.h"
+#include "Comphi/Renderer/Vulkan/Memory/DeferredDeletionQueue.h"
+
+namespace Comphi::Vulkan {
+
+#pragma region RenderGraphPass
+
+	void RenderGraphPass::writeColor(RenderGraphResource resource, bool clear, VkClearColorValue clearValue)
+	{
+		ResourceUse use{ resource, ColorAttachmentWrite, clear };
+		use.clearValue.color = clearValue;
+		uses.push_back(use);
+	}
+
+	void RenderGraphPass::writeDepth(RenderGraphResource resource, bool clear, VkClearDepthStencilValue clearValue)
+	{
+		ResourceUse use{ resource, DepthAttachmentWrite, clear };
+		use.clearValue.depthStencil = clearValue;
+		uses.push_back(use);
+	}
+
+	void RenderGraphPass::readDepth(RenderGraphResource resource)
+	{
+		uses.push_back({ resource, DepthAttachmentRead });
+	}
+
+	void RenderGraphPass::readTexture(RenderGraphResource resource)
+	{
+		uses.push_back({ resource, FragmentShaderRead });
+	}
+
+	bool RenderGraphPass::hasAttachments() const
+	{
+		for (const auto& use : uses) {
+			if (use.access != FragmentShaderRead) return true;
+		}
+		return false;
+	}
+
+#pragma endregion
+
+	RenderGraphResource RenderGraph::importImage(const std::string& name, const RenderGraphImageDesc& desc, const std::vector<VkImage>& images, const std::vector<VkImageView>& views, VkImageLayout finalLayout)
+	{
+		Resource resource;
+		resource.name = name;
+		resource.desc = desc;
+		resource.imported = true;
+		resource.images = images;
+		resource.views = views;
+		resource.finalLayout = finalLayout;
+		resources.push_back(resource);
+		return static_cast<RenderGraphResource>(resources.size() - 1);
+	}
+
+	RenderGraphResource RenderGraph::createImage(const std::string& name, const RenderGraphImageDesc& desc)
+	{
+		Resource resource;
+		resource.name = name;
+		resource.desc = desc;
+		resources.push_back(resource);
+		return static_cast<RenderGraphResource>(resources.size() - 1);
+	}
+
+	RenderGraphPass& RenderGraph::addPass(const std::string& name, VkSubpassContents contents, RenderGraphPass::ExecuteCallback execute)
+	{
+		RenderGraphPass& pass = passes.emplace_back();
+		pass.name = name;
+		pass.contents = contents;
+		pass.execute = execute;
+		return pass;
+	}
+
+	RenderGraph::ResourceState RenderGraph::getAccessState(RenderGraphAccess access)
+	{
+		ResourceState state;
+		switch (access)
+		{
+		case ColorAttachmentWrite:
+			state.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			state.stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			state.access = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			state.write = true;
+			break;
+		case DepthAttachmentWrite:
+			state.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			state.stages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			state.access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			state.write = true;
+			break;
+		case DepthAttachmentRead:
+			state.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+			state.stages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			state.access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+			break;
+		case FragmentShaderRead:
+			state.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			state.stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			state.access = VK_ACCESS_SHADER_READ_BIT;
+			break;
+		}
+		return state;
+	}
+
+	void RenderGraph::compile(VkExtent2D extent)
+	{
+		this->extent = extent;
+
+		cullPasses();
+		computeLifetimes();
+		allocateTransientImages();
+		createRenderPasses();
+		createFramebuffers();
+		planBarriers();
+
+		uint keptPasses = 0;
+		for (const auto& pass : passes) {
+			if (!pass.culled) keptPasses++;
+		}
+		VkDeviceSize transientBytes = 0;
+		VkDeviceSize slotBytes = 0;
+		for (const auto& slot : memorySlots) {
+			slotBytes += slot.requirements.size;
+			for (RenderGraphResource resource : slot.resources) {
+				transientBytes += resources[resource].memoryRequirements.size;
+			}
+		}
+		COMPHILOG_CORE_INFO("RenderGraph compiled : {0}/{1} passes, {2} KB of transient images in {3} KB ({4} memory slots)", keptPasses, passes.size(), transientBytes / 1024, slotBytes / 1024, memorySlots.size());
+	}
+
+	void RenderGraph::cullPasses()
+	{
+		for (auto& resource : resources) {
+			//imported images with a final layout are the graph outputs
+			resource.refCount = resource.imported && resource.finalLayout != VK_IMAGE_LAYOUT_UNDEFINED ? 1 : 0;
+		}
+		std::vector<bool> used(resources.size(), false);
+		for (auto& pass : passes) {
+			pass.culled = false;
+			pass.refCount = 0;
+			for (auto& use : pass.uses) {
+				bool write = getAccessState(use.access).write;
+				//loading the content of earlier passes keeps them alive like a read
+				use.loadsPrevious = write && !use.clear && used[use.resource];
+				if (write) pass.refCount++;
+				if (!write || use.loadsPrevious) resources[use.resource].refCount++;
+			}
+			for (const auto& use : pass.uses) used[use.resource] = true;
+		}
+
+		std::stack<RenderGraphResource> unreferenced;
+		auto cullPass = [&](RenderGraphPass& pass) {
+			pass.culled = true;
+			for (const auto& use : pass.uses) {
+				if (getAccessState(use.access).write && !use.loadsPrevious) continue;
+				if (--resources[use.resource].refCount == 0) unreferenced.push(use.resource);
+			}
+		};
+
+		//resources are pushed once, when their count reaches 0
+		for (RenderGraphResource i = 0; i < resources.size(); i++) {
+			if (resources[i].refCount == 0) unreferenced.push(i);
+		}
+		for (auto& pass : passes) {
+			if (pass.refCount == 0 && !pass.sideEffects) cullPass(pass);
+		}
+
+		//nothing reads the resource : its writers lose a reference
+		while (!unreferenced.empty()) {
+			RenderGraphResource resource = unreferenced.top();
+			unreferenced.pop();
+
+			for (auto& pass : passes) {
+				if (pass.culled || pass.sideEffects) continue;
+				for (const auto& use : pass.uses) {
+					if (use.resource != resource || !getAccessState(use.access).write) continue;
+					if (--pass.refCount == 0) cullPass(pass);
+					break;
+				}
+			}
+		}
+	}
+
+	void RenderGraph::computeLifetimes()
+	{
+		versionCount = 1;
+		for (auto& resource : resources) {
+			resource.firstPass = UINT32_MAX;
+			resource.lastPass = 0;
+			resource.usage = 0;
+			resource.endState = ResourceState();
+			if (resource.imported) versionCount = (std::max)(versionCount, (uint)resource.images.size());
+		}
+
+		for (uint i = 0; i < passes.size(); i++) {
+			if (passes[i].culled) continue;
+
+			for (const auto& use : passes[i].uses) {
+				Resource& resource = resources[use.resource];
+				resource.firstPass = (std::min)(resource.firstPass, i);
+				resource.lastPass = (std::max)(resource.lastPass, i);
+
+				switch (use.access)
+				{
+				case ColorAttachmentWrite: resource.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT; break;
+				case DepthAttachmentWrite:
+				case DepthAttachmentRead: resource.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT; break;
+				case FragmentShaderRead: resource.usage |= VK_IMAGE_USAGE_SAMPLED_BIT; break;
+				}
+			}
+		}
+	}
+
+	void RenderGraph::allocateTransientImages()
+	{
+		VkDevice device = GraphicsHandler::get()->logicalDevice;
+
+		std::vector<RenderGraphResource> transients;
+		for (RenderGraphResource i = 0; i < resources.size(); i++) {
+			Resource& resource = resources[i];
+			if (resource.imported || resource.firstPass == UINT32_MAX) continue;
+
+			if (resource.desc.extent.width == 0 || resource.desc.extent.height == 0) {
+				resource.desc.extent = extent;
+			}
+
+			VkImageCreateInfo imageInfo{};
+			imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.extent = { resource.desc.extent.width, resource.desc.extent.height, 1 };
+			imageInfo.mipLevels = 1;
+			imageInfo.arrayLayers = 1;
+			imageInfo.format = resource.desc.format;
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			imageInfo.usage = resource.usage;
+			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+
+			VkImage image;
+			vkCheckError(vkCreateImage(device, &imageInfo, nullptr, &image)) {
+				COMPHILOG_CORE_FATAL("failed to create render graph image {0}!", resource.name);
+				throw std::runtime_error("failed to create render graph image!");
+			}
+			resource.images = { image };
+			vkGetImageMemoryRequirements(device, image, &resource.memoryRequirements);
+			transients.push_back(i);
+		}
+
+		//first fit by first use : a slot is reused once its last image is done before the next one starts
+		std::stable_sort(transients.begin(), transients.end(), [this](RenderGraphResource a, RenderGraphResource b) {
+			return resources[a].firstPass < resources[b].firstPass;
+		});
+
+		memorySlots.clear();
+		for (RenderGraphResource transient : transients) {
+			Resource& resource = resources[transient];
+
+			uint slotIndex = UINT32_MAX;
+			for (uint s = 0; s < memorySlots.size(); s++) {
+				const MemorySlot& slot = memorySlots[s];
+				if (resources[slot.resources.back()].lastPass >= resource.firstPass) continue;
+				if ((slot.requirements.memoryTypeBits & resource.memoryRequirements.memoryTypeBits) == 0) continue;
+				slotIndex = s;
+				break;
+			}
+
+			if (slotIndex == UINT32_MAX) {
+				slotIndex = static_cast<uint>(memorySlots.size());
+				MemorySlot& slot = memorySlots.emplace_back();
+				slot.requirements = resource.memoryRequirements;
+			}
+			else {
+				VkMemoryRequirements& requirements = memorySlots[slotIndex].requirements;
+				requirements.size = (std::max)(requirements.size, resource.memoryRequirements.size);
+				requirements.alignment = (std::max)(requirements.alignment, resource.memoryRequirements.alignment);
+				requirements.memoryTypeBits &= resource.memoryRequirements.memoryTypeBits;
+			}
+			memorySlots[slotIndex].resources.push_back(transient);
+			resource.memorySlot = slotIndex;
+		}
+
+		for (auto& slot : memorySlots) {
+			slot.allocation = DeviceMemoryAllocator::get()->allocate(slot.requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, DeviceMemoryAllocator::ImageResource);
+
+			for (RenderGraphResource transient : slot.resources) {
+				Resource& resource = resources[transient];
+				vkBindImageMemory(device, resource.images[0], slot.allocation.memory, slot.allocation.offset);
+
+				VkImageViewCreateInfo viewInfo{};
+				viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+				viewInfo.image = resource.images[0];
+				viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+				viewInfo.format = resource.desc.format;
+				viewInfo.subresourceRange = { resource.desc.aspectFlags, 0, 1, 0, 1 };
+
+				VkImageView view;
+				vkCheckError(vkCreateImageView(device, &viewInfo, nullptr, &view)) {
+					COMPHILOG_CORE_FATAL("failed to create render graph image view {0}!", resource.name);
+					throw std::runtime_error("failed to create render graph image view!");
+				}
+				resource.views = { view };
+			}
+		}
+	}
+
+	bool RenderGraph::isLoadedAfter(RenderGraphResource resource, uint passIndex) const
+	{
+		const Resource& graphResource = resources[resource];
+		if (graphResource.imported && graphResource.finalLayout != VK_IMAGE_LAYOUT_UNDEFINED) return true;
+
+		for (uint i = passIndex + 1; i < passes.size(); i++) {
+			if (passes[i].culled) continue;
+			for (const auto& use : passes[i].uses) {
+				//a clearing write doesn't need the previous content
+				if (use.resource == resource && !(getAccessState(use.access).write && use.clear)) return true;
+			}
+		}
+		return false;
+	}
+
+	void RenderGraph::createRenderPasses()
+	{
+		for (uint p = 0; p < passes.size(); p++) {
+			RenderGraphPass& pass = passes[p];
+			if (pass.culled || !pass.hasAttachments()) continue;
+
+			std::vector<VkAttachmentDescription> attachments;
+			std::vector<VkAttachmentReference> colorReferences;
+			VkAttachmentReference depthReference{ VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED };
+			std::string key;
+
+			for (const auto& use : pass.uses) {
+				if (use.access == FragmentShaderRead) continue;
+				const Resource& resource = resources[use.resource];
+				ResourceState state = getAccessState(use.access);
+
+				//the barriers before the pass do the layout transitions
+				VkAttachmentDescription attachment{};
+				attachment.format = resource.desc.format;
+				attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+				if (use.clear && state.write) attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+				else if (resource.firstPass == p) attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				else attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+				attachment.storeOp = isLoadedAfter(use.resource, p) ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				attachment.initialLayout = state.layout;
+				attachment.finalLayout = state.layout;
+
+				VkAttachmentReference reference{ static_cast<uint32_t>(attachments.size()), state.layout };
+				if (use.access == ColorAttachmentWrite) colorReferences.push_back(reference);
+				else depthReference = reference;
+
+				attachments.push_back(attachment);
+				key += std::to_string(attachment.format) + ":" + std::to_string(attachment.initialLayout) + ":" + std::to_string(attachment.loadOp) + ":" + std::to_string(attachment.storeOp) + ";";
+				pass.extent = resource.imported ? extent : resource.desc.extent;
+			}
+
+			CachedRenderPass& cached = renderPassCache[pass.name];
+			pass.renderPass = &cached.renderPassObj;
+			if (cached.renderPassObj != VK_NULL_HANDLE && cached.key == key) continue;
+
+			if (cached.renderPassObj != VK_NULL_HANDLE) {
+				VkRenderPass retired = cached.renderPassObj;
+				DeferredDeletionQueue::get()->enqueue([retired]() {
+					COMPHILOG_CORE_INFO("vkDestroy Destroy RenderPass");
+					vkDestroyRenderPass(GraphicsHandler::get()->logicalDevice, retired, nullptr);
+				});
+			}
+
+			VkSubpassDescription subpass{};
+			subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+			subpass.colorAttachmentCount = static_cast<uint32_t>(colorReferences.size());
+			subpass.pColorAttachments = colorReferences.data();
+			subpass.pDepthStencilAttachment = depthReference.attachment != VK_ATTACHMENT_UNUSED ? &depthReference : nullptr;
+
+			VkRenderPassCreateInfo renderPassInfo{};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+			renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+			renderPassInfo.pAttachments = attachments.data();
+			renderPassInfo.subpassCount = 1;
+			renderPassInfo.pSubpasses = &subpass;
+
+			vkCheckError(vkCreateRenderPass(GraphicsHandler::get()->logicalDevice, &renderPassInfo, nullptr, &cached.renderPassObj)) {
+				COMPHILOG_CORE_FATAL("failed to create render pass {0}!", pass.name);
+				throw std::runtime_error("failed to create render pass!");
+			}
+			cached.key = key;
+			COMPHILOG_CORE_INFO("created RenderPass {0} Successfully!", pass.name);
+		}
+	}
+
+	void RenderGraph::createFramebuffers()
+	{
+		for (auto& pass : passes) {
+			if (pass.culled || !pass.hasAttachments()) continue;
+
+			//one framebuffer per version when an imported image is attached
+			uint framebufferCount = 1;
+			for (const auto& use : pass.uses) {
+				if (use.access != FragmentShaderRead && resources[use.resource].imported) framebufferCount = versionCount;
+			}
+
+			pass.framebuffers.resize(framebufferCount);
+			for (uint v = 0; v < framebufferCount; v++) {
+				std::vector<VkImageView> attachments;
+				for (const auto& use : pass.uses) {
+					if (use.access == FragmentShaderRead) continue;
+					const Resource& resource = resources[use.resource];
+					attachments.push_back(resource.views[v % resource.views.size()]);
+				}
+
+				VkFramebufferCreateInfo framebufferInfo{};
+				framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+				framebufferInfo.renderPass = *pass.renderPass;
+				framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+				framebufferInfo.pAttachments = attachments.data();
+				framebufferInfo.width = pass.extent.width;
+				framebufferInfo.height = pass.extent.height;
+				framebufferInfo.layers = 1;
+
+				vkCheckError(vkCreateFramebuffer(GraphicsHandler::get()->logicalDevice, &framebufferInfo, nullptr, &pass.framebuffers[v])) {
+					COMPHILOG_CORE_FATAL("failed to create framebuffer of pass {0}!", pass.name);
+					throw std::runtime_error("failed to create framebuffer!");
+				}
+			}
+		}
+	}
+
+	void RenderGraph::planBarriers()
+	{
+		//imported images wait on the acquire semaphore at COLOR_ATTACHMENT_OUTPUT, the barrier chains to it
+		auto initialState = [this](RenderGraphResource r) {
+			ResourceState state;
+			if (resources[r].imported) {
+				state.stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+				return state;
+			}
+
+			//aliased images wait for the previous image of their slot (the last one of the previous frame for the first)
+			const MemorySlot& slot = memorySlots[resources[r].memorySlot];
+			auto it = std::find(slot.resources.begin(), slot.resources.end(), r);
+			RenderGraphResource previous = it == slot.resources.begin() ? slot.resources.back() : *(it - 1);
+			state.stages = resources[previous].endState.stages;
+			state.access = resources[previous].endState.access;
+			state.write = resources[previous].endState.write;
+			return state;
+		};
+
+		//run twice : the first run finds the end states the aliased images wait on (they don't depend on the initial states)
+		for (uint run = 0; run < 2; run++) {
+			std::vector<ResourceState> states(resources.size());
+			for (RenderGraphResource r = 0; r < resources.size(); r++) {
+				if (resources[r].firstPass == UINT32_MAX) continue;
+				states[r] = initialState(r);
+			}
+
+			for (auto& pass : passes) {
+				pass.barriers.clear();
+				pass.barrierResources.clear();
+				pass.barrierSrcStages = 0;
+				pass.barrierDstStages = 0;
+				if (pass.culled) continue;
+
+				for (const auto& use : pass.uses) {
+					ResourceState needed = getAccessState(use.access);
+					ResourceState& current = states[use.resource];
+
+					//read after read in the same layout : no barrier, a later write waits on every reader
+					if (current.layout == needed.layout && !current.write && !needed.write) {
+						current.stages |= needed.stages;
+						current.access |= needed.access;
+						continue;
+					}
+
+					VkImageMemoryBarrier barrier{};
+					barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+					barrier.oldLayout = current.layout;
+					barrier.newLayout = needed.layout;
+					barrier.srcAccessMask = current.write ? current.access : 0; //write after read only needs the execution dependency
+					barrier.dstAccessMask = needed.access;
+					barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					barrier.subresourceRange = { resources[use.resource].desc.aspectFlags, 0, 1, 0, 1 };
+
+					pass.barriers.push_back(barrier);
+					pass.barrierResources.push_back(use.resource);
+					pass.barrierSrcStages |= current.stages;
+					pass.barrierDstStages |= needed.stages;
+					current = needed;
+				}
+			}
+
+			for (RenderGraphResource r = 0; r < resources.size(); r++) {
+				if (resources[r].firstPass != UINT32_MAX) resources[r].endState = states[r];
+			}
+		}
+
+		finalBarriers.clear();
+		finalBarrierResources.clear();
+		finalSrcStages = 0;
+		for (RenderGraphResource r = 0; r < resources.size(); r++) {
+			const Resource& resource = resources[r];
+			if (!resource.imported || resource.firstPass == UINT32_MAX || resource.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED) continue;
+			if (resource.endState.layout == resource.finalLayout) continue;
+
+			//presentation is ordered by the render finished semaphore
+			VkImageMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.oldLayout = resource.endState.layout;
+			barrier.newLayout = resource.finalLayout;
+			barrier.srcAccessMask = resource.endState.write ? resource.endState.access : 0;
+			barrier.dstAccessMask = 0;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.subresourceRange = { resource.desc.aspectFlags, 0, 1, 0, 1 };
+
+			finalBarriers.push_back(barrier);
+			finalBarrierResources.push_back(r);
+			finalSrcStages |= resource.endState.stages;
+		}
+	}
+
+	VkImage RenderGraph::getImage(RenderGraphResource resource, uint version) const
+	{
+		const std::vector<VkImage>& images = resources[resource].images;
+		return images[version % images.size()];
+	}
+
+	void RenderGraph::execute(VkCommandBuffer& commandBuffer, uint importedVersion)
+	{
+		for (auto& pass : passes) {
+			if (pass.culled) continue;
+
+			if (!pass.barriers.empty()) {
+				for (size_t i = 0; i < pass.barriers.size(); i++) {
+					pass.barriers[i].image = getImage(pass.barrierResources[i], importedVersion);
+				}
+				vkCmdPipelineBarrier(commandBuffer, pass.barrierSrcStages, pass.barrierDstStages, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(pass.barriers.size()), pass.barriers.data());
+			}
+
+			RenderGraphPassContext context;
+			context.extent = pass.extent;
+			if (!pass.hasAttachments()) {
+				pass.execute(commandBuffer, context);
+				continue;
+			}
+
+			context.renderPass = *pass.renderPass;
+			context.framebuffer = pass.framebuffers[pass.framebuffers.size() > 1 ? importedVersion % pass.framebuffers.size() : 0];
+
+			std::vector<VkClearValue> clearValues; //same order as attachments
+			for (const auto& use : pass.uses) {
+				if (use.access != FragmentShaderRead) clearValues.push_back(use.clearValue);
+			}
+
+			VkRenderPassBeginInfo renderPassInfo{};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassInfo.renderPass = context.renderPass;
+			renderPassInfo.framebuffer = context.framebuffer;
+			renderPassInfo.renderArea.offset = { 0, 0 };
+			renderPassInfo.renderArea.extent = pass.extent;
+			renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+			renderPassInfo.pClearValues = clearValues.data();
+
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, pass.contents);
+			pass.execute(commandBuffer, context);
+			vkCmdEndRenderPass(commandBuffer);
+		}
+
+		if (!finalBarriers.empty()) {
+			for (size_t i = 0; i < finalBarriers.size(); i++) {
+				finalBarriers[i].image = getImage(finalBarrierResources[i], importedVersion);
+			}
+			vkCmdPipelineBarrier(commandBuffer, finalSrcStages, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(finalBarriers.size()), finalBarriers.data());
+		}
+	}
+
+	void RenderGraph::reset()
+	{
+		//frames in flight may still use the compiled objects
+		std::vector<VkFramebuffer> framebuffers;
+		for (const auto& pass : passes) {
+			framebuffers.insert(framebuffers.end(), pass.framebuffers.begin(), pass.framebuffers.end());
+		}
+		std::vector<VkImage> images;
+		std::vector<VkImageView> views;
+		for (const auto& resource : resources) {
+			if (resource.imported) continue;
+			images.insert(images.end(), resource.images.begin(), resource.images.end());
+			views.insert(views.end(), resource.views.begin(), resource.views.end());
+		}
+		std::vector<MemoryAllocation> allocations;
+		for (const auto& slot : memorySlots) {
+			allocations.push_back(slot.allocation);
+		}
+
+		if (!framebuffers.empty() || !images.empty() || !allocations.empty()) {
+			DeferredDeletionQueue::get()->enqueue([framebuffers, images, views, allocations]() mutable {
+				VkDevice device = GraphicsHandler::get()->logicalDevice;
+				for (VkFramebuffer framebuffer : framebuffers) {
+					COMPHILOG_CORE_INFO("vkDestroy Destroy framebuffer");
+					vkDestroyFramebuffer(device, framebuffer, nullptr);
+				}
+				for (VkImageView view : views) {
+					COMPHILOG_CORE_INFO("vkDestroy Destroy RenderGraph ImageView");
+					vkDestroyImageView(device, view, nullptr);
+				}
+				for (VkImage image : images) {
+					COMPHILOG_CORE_INFO("vkDestroy Destroy RenderGraph Image");
+					vkDestroyImage(device, image, nullptr);
+				}
+				for (auto& allocation : allocations) {
+					DeviceMemoryAllocator::get()->free(allocation);
+				}
+			});
+		}
+
+		resources.clear();
+		passes.clear();
+		memorySlots.clear();
+		finalBarriers.clear();
+		finalBarrierResources.clear();
+	}
+
+	void RenderGraph::cleanUp()
+	{
+		reset();
+
+		for (auto& cached : renderPassCache) {
+			VkRenderPass renderPass = cached.second.renderPassObj;
+			if (renderPass == VK_NULL_HANDLE) continue;
+			DeferredDeletionQueue::get()->enqueue([renderPass]() {
+				COMPHILOG_CORE_INFO("vkDestroy Destroy RenderPass");
+				vkDestroyRenderPass(GraphicsHandler::get()->logicalDevice, renderPass, nullptr);
+			});
+		}
+		renderPassCache.clear();
+	}
+
+	VkRenderPass& RenderGraph::getRenderPass(const std::string& passName)
+	{
+		return renderPassCache[passName].renderPassObj;
+	}
+
+}
@@ -0,0 +1,158 @@
+#pragma once
+#include "Comphi/Renderer/Vulkan/GraphicsHandler.h"
+#include "Comphi/Renderer/Vulkan/Memory/DeviceMemoryAllocator.h"
+#include <deque>
+
+namespace Comphi::Vulkan {
+
+	typedef uint RenderGraphResource;
+	static constexpr RenderGraphResource InvalidRenderGraphResource = UINT32_MAX;
+
+	//How a pass uses a resource, the graph derives layouts, stages & access masks from it
+	enum RenderGraphAccess {
+		ColorAttachmentWrite = 0,
+		DepthAttachmentWrite = 1,
+		DepthAttachmentRead = 2, //depth test without writes (after a depth prepass)
+		FragmentShaderRead = 3 //sampled texture
+	};
+
+	struct RenderGraphImageDesc {
+		VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+		VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
+		VkExtent2D extent = { 0, 0 }; //0 : extent of the graph
+	};
+
+	//Handed to the pass callback, secondary command buffers inherit renderPass & framebuffer
+	struct RenderGraphPassContext {
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		VkFramebuffer framebuffer = VK_NULL_HANDLE;
+		VkExtent2D extent;
+	};
+
+	class RenderGraphPass
+	{
+	public:
+		typedef std::function<void(VkCommandBuffer& commandBuffer, const RenderGraphPassContext& context)> ExecuteCallback;
+
+		//attachments are bound in declaration order, clear otherwise loads the previous content
+		void writeColor(RenderGraphResource resource, bool clear = true, VkClearColorValue clearValue = { {0.0f, 0.0f, 0.0f, 1.0f} });
+		void writeDepth(RenderGraphResource resource, bool clear = true, VkClearDepthStencilValue clearValue = { 1.0f, 0 });
+		void readDepth(RenderGraphResource resource);
+		void readTexture(RenderGraphResource resource);
+		//kept even if nothing reads its outputs
+		inline void setSideEffects() { sideEffects = true; }
+
+	protected:
+		friend class RenderGraph;
+
+		struct ResourceUse {
+			RenderGraphResource resource;
+			RenderGraphAccess access;
+			bool clear = false;
+			VkClearValue clearValue{};
+			bool loadsPrevious = false; //compile : non clearing write after an earlier pass, reads the resource too
+		};
+
+		std::string name;
+		VkSubpassContents contents;
+		ExecuteCallback execute;
+		std::vector<ResourceUse> uses;
+		bool sideEffects = false;
+
+		//compile
+		bool culled = false;
+		uint refCount = 0;
+		VkRenderPass* renderPass = nullptr; //cached by name, outlives recompiles
+		VkExtent2D extent{}; //of its attachments
+		std::vector<VkFramebuffer> framebuffers; //[imported version]
+		std::vector<VkImageMemoryBarrier> barriers; //image is patched with the version on execute
+		std::vector<RenderGraphResource> barrierResources;
+		VkPipelineStageFlags barrierSrcStages = 0;
+		VkPipelineStageFlags barrierDstStages = 0;
+
+		bool hasAttachments() const;
+	};
+
+	//Frame render graph : passes declare what they read & write, compile() culls the passes nothing reads,
+	//plans the barriers between them and aliases the memory of transient images whose lifetimes don't overlap
+	//Passes run in declaration order, barriers are recorded outside of the render passes
+	class RenderGraph
+	{
+	public:
+		//images owned outside of the graph (swapchain), versions are selected on execute (image index)
+		//the content is discarded at the start of the frame, finalLayout is set after the last pass
+		RenderGraphResource importImage(const std::string& name, const RenderGraphImageDesc& desc, const std::vector<VkImage>& images, const std::vector<VkImageView>& views, VkImageLayout finalLayout);
+		//images created & aliased by the graph, valid during the frame only
+		RenderGraphResource createImage(const std::string& name, const RenderGraphImageDesc& desc);
+		RenderGraphPass& addPass(const std::string& name, VkSubpassContents contents, RenderGraphPass::ExecuteCallback execute);
+
+		void compile(VkExtent2D extent);
+		void execute(VkCommandBuffer& commandBuffer, uint importedVersion = 0);
+
+		//retires the compiled objects (deferred) and clears the declarations, render passes are kept for pipelines
+		void reset();
+		void cleanUp();
+
+		//valid once a compiled pass of that name exists, the reference stays valid until cleanUp
+		VkRenderPass& getRenderPass(const std::string& passName);
+
+	protected:
+		struct ResourceState {
+			VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkPipelineStageFlags stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			VkAccessFlags access = 0;
+			bool write = false;
+		};
+		static ResourceState getAccessState(RenderGraphAccess access);
+
+		struct Resource {
+			std::string name;
+			RenderGraphImageDesc desc;
+			bool imported = false;
+			VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			std::vector<VkImage> images; //[version]
+			std::vector<VkImageView> views;
+
+			//compile
+			VkImageUsageFlags usage = 0;
+			uint refCount = 0;
+			uint firstPass = UINT32_MAX;
+			uint lastPass = 0;
+			uint memorySlot = UINT32_MAX;
+			VkMemoryRequirements memoryRequirements{};
+			ResourceState endState; //after its last pass
+		};
+
+		//transient images with disjoint lifetimes share one slot
+		struct MemorySlot {
+			std::vector<RenderGraphResource> resources; //by first use
+			VkMemoryRequirements requirements{};
+			MemoryAllocation allocation;
+		};
+
+		void cullPasses();
+		void computeLifetimes();
+		void allocateTransientImages();
+		void createRenderPasses();
+		void createFramebuffers();
+		void planBarriers();
+		bool isLoadedAfter(RenderGraphResource resource, uint passIndex) const;
+		VkImage getImage(RenderGraphResource resource, uint version) const;
+
+		VkExtent2D extent{};
+		std::vector<Resource> resources;
+		std::deque<RenderGraphPass> passes; //addPass references stay valid
+		std::vector<MemorySlot> memorySlots;
+		std::vector<VkImageMemoryBarrier> finalBarriers;
+		std::vector<RenderGraphResource> finalBarrierResources;
+		VkPipelineStageFlags finalSrcStages = 0;
+		uint versionCount = 1;
+
+		struct CachedRenderPass {
+			std::string key; //attachment formats, layouts & load/store ops
+			VkRenderPass renderPassObj = VK_NULL_HANDLE;
+		};
+		std::map<std::string, CachedRenderPass> renderPassCache; //by pass name, nodes keep their address
+	};
+
+}
@@ -3,6 +3,10 @@
 #include "Comphi/API/Components/Transform.h"
 #include "Comphi/API/Rendering/ShaderBinding.h"
 #include "Comphi/Renderer/Vulkan/Buffers/UniformBuffer.h"
+#include "Comphi/Renderer/Vulkan/Buffers/GeometryPool.h"
+#include "Comphi/Renderer/Vulkan/Buffers/UploadManager.h"
+#include "Comphi/Renderer/Vulkan/Memory/DeferredDeletionQueue.h"
+#include "Comphi/Core/ThreadPool.h"
 
 namespace Comphi::Vulkan {
 
@@ -22,6 +26,13 @@ namespace Comphi::Vulkan {
 	void GraphicsContext::Init()
 	{
 		graphicsInstance = std::make_unique<GraphicsInstance>();
+		frameUniforms = std::make_unique<FrameRingBuffer>(graphicsInstance->swapchain->MAX_FRAMES_IN_FLIGHT);
+		descriptorAllocator = std::make_unique<DescriptorAllocator>(graphicsInstance->swapchain->MAX_FRAMES_IN_FLIGHT);
+		threadCommandPools = std::make_unique<ThreadCommandPools>(graphicsInstance->swapchain->MAX_FRAMES_IN_FLIGHT, ThreadPool::get()->getThreadCount() + 1);
+		ImageView::initPlaceholderTexture();
+
+		renderGraph = std::make_unique<RenderGraph>();
+		buildRenderGraph();
 	}
 
 	void GraphicsContext::SetScenes(SceneGraphPtr& sceneGraph)
@@ -31,168 +42,349 @@ namespace Comphi::Vulkan {
 
 #pragma region //DEBUG!
 
-	std::shared_ptr<UniformBuffer> bufferInstanceTransforms;
-	void GraphicsContext::updateSceneLoop() {
-		
-		FrameTime.Stop();
+	//mesh groups drawn by one indirect draw : same GeometryPool page, and only one group per draw without drawIndirectFirstInstance
+	//(firstInstance of the indirect commands is relative to the run, DrawPushConstants::instanceBase adds the run start)
+	static bool isSameDrawRun(const RenderMeshInstance& previous, const RenderMeshInstance& meshInstance)
+	{
+		if (!GraphicsHandler::get()->enabledFeatures.drawIndirectFirstInstance) return false;
+		return previous.meshObject->meshBuffers.vertexBuffer == meshInstance.meshObject->meshBuffers.vertexBuffer
+			&& previous.meshObject->meshBuffers.indexBuffer == meshInstance.meshObject->meshBuffers.indexBuffer;
+	}
 
-		VkCommandBuffer& commandBuffer = graphicsInstance->swapchain->getCurrentFrameGraphicsCommandBuffer();
-		graphicsInstance->swapchain->beginRenderPassCommandBuffer(commandBuffer);
+	void GraphicsContext::updateBatchInstances(RenderBatch& batch)
+	{
+		uint frame = graphicsInstance->swapchain->currentFrame;
+		batch.instanceBuffers.resize(graphicsInstance->swapchain->MAX_FRAMES_IN_FLIGHT);
+
+		//every mesh group takes a contiguous range, firstInstance of the draw points at it
+		std::vector<glm::mat4> instanceTransforms;
+		instanceTransforms.reserve(batch.getInstanceCount());
+		for (const auto& meshInstance : batch.renderMeshInstances) {
+			for (const auto& entityInst : meshInstance.instancedMeshEntities) {
+				instanceTransforms.push_back(entityInst->GetComponent<Transform>()->getModelMatrix());
+			}
+		}
+		if (instanceTransforms.empty()) return;
 
-		//https://computergraphics.stackexchange.com/questions/4499/how-to-change-sampler-pipeline-states-at-runtime-in-vulkan
-		
-		//MESH INSTANCING (WIP)
-		//was trying to send dynamic storage buffer to binding point 2.2
-		//	-- still trying to figure out how to setup dynamic descriptor set bindings 
-		//can also try to send 4 binding points (vec4 to build model matrix in shader)
-		//	-- through vertexdata binding point 1 using Instanced Rate 
-	
-		//BATCHED DRAW (WIP)
-		//trying to use DrawIndirectIndexed to send a batched drawCall instead of multiple draw cmds
-	
-		//need to fix descriptor binding validation errors first
-		//Traverse Render SceneGraph 
-		for (const auto& cam : sceneGraph->cameras) {
+		//recreated only when the batch membership changes, this frame's previous buffer is no longer in use after its fence
+		BufferDataPtr& instanceBuffer = batch.instanceBuffers[frame];
+		VkDeviceSize instanceBufferSize = instanceTransforms.size() * sizeof(glm::mat4);
+		if (instanceBuffer.get() == nullptr || dynamic_cast<MemBuffer*>(instanceBuffer.get())->bufferSize != instanceBufferSize) {
+			instanceBuffer = std::make_shared<UniformBuffer>(nullptr, sizeof(glm::mat4), instanceTransforms.size(), BufferStorageDynamic);
+		}
+		instanceBuffer->updateBufferData(instanceTransforms.data());
+	}
 
-			//SAME CAMERA
-			glm::mat4 viewProjectionMx = cam.camera->getProjectionMatrix() * cam.transform->getViewMatrix();
-			cam.camera->bufferViewProjectionMatrix->updateBufferData(&viewProjectionMx[0]);
-
-			//dynamic VIEWPORT/SCISSOR SETUP
-			VkViewport viewport{};
-			viewport.x = 0.0f;
-			viewport.y = 0.0f;
-			viewport.width = static_cast<float>(GraphicsHandler::get()->swapChainExtent->width);
-			viewport.height = static_cast<float>(GraphicsHandler::get()->swapChainExtent->height);
-			viewport.minDepth = 0.0f;
-			viewport.maxDepth = 1.0f;
-			vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-
-			VkRect2D scissor{};
-			scissor.offset = { 0, 0 };
-			scissor.extent = *GraphicsHandler::get()->swapChainExtent;
-			vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-
-			for (const auto& batchID : sceneGraph->renderBatches) { //BATCH DRAW
-				
-				//DIFERENT MATERIALS 
-				std::vector<VkWriteDescriptorSet> descriptorSetUpdates;
-				//std::vector<VkWriteDescriptorSet> materialDescriptorSetUpdates;
-				//std::vector<VkWriteDescriptorSet> entityDescriptorSetUpdates;
-
-				//Material binding : 
-				IGraphicsPipelinePtr igraphicsPipeline = batchID.material->getIPipelinePtr(); //TODO: streamline these Interface conversions later
-				GraphicsPipeline* gpipeline = static_cast<GraphicsPipeline*>(igraphicsPipeline.get());
-				
-				//Camera DescriptorSet:
-				auto projectionDescriptor = gpipeline->getDescriptorSetWrite(cam.camera->bufferViewProjectionMatrix.get(), PerMaterialInstance, 0); //<< SetID& DescriptorID need to be dynamic!
-				descriptorSetUpdates.push_back(projectionDescriptor);
-				
-				//Material Descriptor Sets:
-				MaterialInstance* currMaterialInst = batchID.materialInstance.get();
-				auto texureBindings = currMaterialInst->textureBindings[PerMaterialInstance];
-				auto bufferBindings = currMaterialInst->bufferBindings[PerMaterialInstance];
-
-				//Matrial Instance Texture bindings
-				for (auto& sortedBindings : texureBindings) {
-					auto textures = gpipeline->getDescriptorSetWrite(sortedBindings.textures.data(), PerMaterialInstance, sortedBindings.descriptorID);
-					descriptorSetUpdates.push_back(textures);
-				}
+	void GraphicsContext::updateBatchDrawCommands(RenderBatch& batch)
+	{
+		uint frame = graphicsInstance->swapchain->currentFrame;
+		batch.drawCommandBuffers.resize(graphicsInstance->swapchain->MAX_FRAMES_IN_FLIGHT);
+		batch.drawCommandVersions.resize(graphicsInstance->swapchain->MAX_FRAMES_IN_FLIGHT, 0);
+		if (batch.drawCommandVersions[frame] == batch.membershipVersion) return;
+
+		//same mesh group order as updateBatchInstances, so instances match the instance buffer ranges
+		std::vector<VkDrawIndexedIndirectCommand> batchDraws;
+		uint firstInstance = 0;
+		uint runFirstInstance = 0;
+		const RenderMeshInstance* previous = nullptr;
+		for (const auto& meshInstance : batch.renderMeshInstances)
+		{
+			if (previous == nullptr || !isSameDrawRun(*previous, meshInstance)) runFirstInstance = firstInstance;
+
+			VkDrawIndexedIndirectCommand drawInstance = {};
+			drawInstance.indexCount = meshInstance.meshObject->meshData.indexData.size();
+			drawInstance.instanceCount = meshInstance.instancedMeshEntities.size();
+			drawInstance.firstIndex = meshInstance.meshObject->meshBuffers.firstIndex;
+			drawInstance.vertexOffset = meshInstance.meshObject->meshBuffers.vertexOffset;
+			drawInstance.firstInstance = firstInstance - runFirstInstance;
+			firstInstance += drawInstance.instanceCount;
+
+			batchDraws.push_back(drawInstance);
+			previous = &meshInstance;
+		}
+		if (batchDraws.empty()) return;
 
-				//Matrial Instance Buffer Bindings
-				for (auto& sortedBindings : bufferBindings) {
-					auto buffers = gpipeline->getDescriptorSetWrite(sortedBindings.buffers.data(), PerMaterialInstance, sortedBindings.descriptorID);
-					descriptorSetUpdates.push_back(buffers);
-				}
+		batch.drawCommandBuffers[frame] = std::make_shared<UniformBuffer>(batchDraws.data(), sizeof(VkDrawIndexedIndirectCommand), batchDraws.size(), DrawIndirect);
+		batch.drawCommandVersions[frame] = batch.membershipVersion;
+	}
+
+	void GraphicsContext::drawIndexedIndirect(VkCommandBuffer& commandBuffer, VkBuffer drawCommands, uint firstDraw, uint drawCount)
+	{
+		const uint stride = sizeof(VkDrawIndexedIndirectCommand);
+		if (GraphicsHandler::get()->enabledFeatures.multiDrawIndirect) {
+			vkCmdDrawIndexedIndirect(commandBuffer, drawCommands, firstDraw * stride, drawCount, stride);
+			return;
+		}
+
+		//without multiDrawIndirect drawCount must be 1
+		for (uint i = 0; i < drawCount; i++) {
+			vkCmdDrawIndexedIndirect(commandBuffer, drawCommands, (firstDraw + i) * stride, 1, stride);
+		}
+	}
+
+	bool GraphicsContext::prepareBatch(const RenderBatch& batchID, const RingAllocation& viewProjection, PreparedBatch& prepared)
+	{
+		//pipeline still compiling in the background
+		if (!batchID.material->isReady()) return false;
+
+		uint frame = graphicsInstance->swapchain->currentFrame;
+		const BufferDataPtr& instanceBuffer = batchID.instanceBuffers[frame];
+		const BufferDataPtr& drawCommandBuffer = batchID.drawCommandBuffers[frame];
+		if (instanceBuffer.get() == nullptr || drawCommandBuffer.get() == nullptr) return false;
+
+		prepared.batch = &batchID;
+		prepared.drawCommands = dynamic_cast<MemBuffer*>(drawCommandBuffer.get())->bufferObj;
+
+		//DIFERENT MATERIALS 
+		std::vector<VkWriteDescriptorSet> descriptorSetUpdates;
+
+		//Material binding : 
+		IGraphicsPipelinePtr igraphicsPipeline = batchID.material->getIPipelinePtr(); //TODO: streamline these Interface conversions later
+		GraphicsPipeline* gpipeline = static_cast<GraphicsPipeline*>(igraphicsPipeline.get());
+		prepared.pipeline = gpipeline;
+		prepared.dynamicOffsets = gpipeline->createDynamicOffsets(PerMaterialInstance);
+
+		//Camera DescriptorSet: (dynamic -> the set stays the same every frame, only the offset changes)
+		if (gpipeline->isDynamicBinding(PerMaterialInstance, 0)) {
+			auto projectionDescriptor = gpipeline->getDescriptorSetWrite({ viewProjection.buffer, 0, viewProjection.size }, PerMaterialInstance, 0);
+			descriptorSetUpdates.push_back(projectionDescriptor);
+			prepared.dynamicOffsets[gpipeline->getDynamicOffsetIndex(PerMaterialInstance, 0)] = viewProjection.offset;
+		}
+		else {
+			auto projectionDescriptor = gpipeline->getDescriptorSetWrite(viewProjection.getDescriptorInfo(), PerMaterialInstance, 0); //<< SetID& DescriptorID need to be dynamic!
+			descriptorSetUpdates.push_back(projectionDescriptor);
+		}
+
+		//Material Descriptor Sets:
+		MaterialInstance* currMaterialInst = batchID.materialInstance.get();
+		auto texureBindings = currMaterialInst->textureBindings[PerMaterialInstance];
+		auto bufferBindings = currMaterialInst->bufferBindings[PerMaterialInstance];
+
+		//Matrial Instance Texture bindings
+		for (auto& sortedBindings : texureBindings) {
+			auto textures = gpipeline->getDescriptorSetWrite(sortedBindings.textures.data(), PerMaterialInstance, sortedBindings.descriptorID);
+			descriptorSetUpdates.push_back(textures);
+		}
+
+		//Matrial Instance Buffer Bindings
+		for (auto& sortedBindings : bufferBindings) {
+			auto buffers = gpipeline->getDescriptorSetWrite(sortedBindings.buffers.data(), PerMaterialInstance, sortedBindings.descriptorID);
+			descriptorSetUpdates.push_back(buffers);
+		}
+
+		//Instanced Entity Transforms Descriptor (indexed by gl_InstanceIndex):
+		auto instancedModelsDescriptor = gpipeline->getDescriptorSetWrite(instanceBuffer.get(), PerMaterialInstance, 2); //<< SetID & DescriptorID need to be dynamic!
+		descriptorSetUpdates.push_back(instancedModelsDescriptor);
+
+		//unchanged resources reuse the set written on a previous frame, new sets are never in use
+		VkDescriptorSetLayout setLayout = gpipeline->getDescriptorSetLayout(PerMaterialInstance);
+		std::string resourceKey = DescriptorAllocator::getDescriptorWritesKey(setLayout, descriptorSetUpdates);
+		bool isNewSet = false;
+		prepared.descriptorSet = descriptorAllocator->getDescriptorSet(setLayout, resourceKey, isNewSet);
+		if (isNewSet) {
+			for (auto& write : descriptorSetUpdates) {
+				write.dstSet = prepared.descriptorSet;
+			}
+			vkUpdateDescriptorSets(GraphicsHandler::get()->logicalDevice, descriptorSetUpdates.size(), descriptorSetUpdates.data(), 0, 0);
+		}
+
+		for (auto& var : descriptorSetUpdates)
+		{
+			if (var.pBufferInfo != NULL) {
+				delete(var.pBufferInfo);
+			}
+			if (var.pImageInfo != NULL) {
+				delete(var.pImageInfo);
+			}
+		}
+		return true;
+	}
+
+	void GraphicsContext::recordBatches(VkCommandBuffer& commandBuffer, const std::vector<PreparedBatch>& preparedBatches, uint begin, uint end)
+	{
+		//dynamic VIEWPORT/SCISSOR SETUP (not inherited by secondary command buffers)
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(GraphicsHandler::get()->swapChainExtent->width);
+		viewport.height = static_cast<float>(GraphicsHandler::get()->swapChainExtent->height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+		VkRect2D scissor{};
+		scissor.offset = { 0, 0 };
+		scissor.extent = *GraphicsHandler::get()->swapChainExtent;
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		VkPipeline boundPipeline = VK_NULL_HANDLE;
+		for (uint i = begin; i < end; i++) { //BATCH DRAW
+
+			const PreparedBatch& prepared = preparedBatches[i];
+			GraphicsPipeline* gpipeline = prepared.pipeline;
+
+			//materials sharing a pipeline are sorted next to each other
+			if (gpipeline->pipelineObj != boundPipeline) {
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, gpipeline->pipelineObj);
+				boundPipeline = gpipeline->pipelineObj;
+			}
+			gpipeline->bindDescriptorSet(commandBuffer, PerMaterialInstance, prepared.descriptorSet, prepared.dynamicOffsets);
+
+			//BATCHED DRAW : one indirect draw per run of mesh groups (isSameDrawRun)
+			//per draw values are pushed before each run, from this recording thread's own state
+			DrawPushConstants drawConstants;
+			auto drawRun = [&](uint firstDraw, uint drawCount) {
+				gpipeline->pushConstants(commandBuffer, 0, sizeof(DrawPushConstants), &drawConstants);
+				drawIndexedIndirect(commandBuffer, prepared.drawCommands, firstDraw, drawCount);
+			};
+
+			VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+			VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+			const RenderMeshInstance* previous = nullptr;
+			uint runBegin = 0;
+			uint drawIndex = 0;
+			uint firstInstance = 0;
+			for (const auto& meshInstance : prepared.batch->renderMeshInstances) //MESH INSTANCES GROUP
+			{
+				if (previous == nullptr || !isSameDrawRun(*previous, meshInstance)) {
+					if (drawIndex > runBegin) drawRun(runBegin, drawIndex - runBegin);
+					runBegin = drawIndex;
+					drawConstants.instanceBase = firstInstance;
 
-				//std::vector<VkDrawIndexedIndirectCommand> batchDraws;
-				for (const auto& meshInstance : batchID.renderMeshInstances) //MESH INSTANCES GROUP
-				{
 					//  SAME MATERIAL + DIFFERENT MESHES
-					// --- 
-					
-					//Move this to function, build a unique buffer with all instanced objects to draw in a single call
 					auto vbuffer = static_cast<IUniformBuffer*>(meshInstance.meshObject->meshBuffers.vertexBuffer.get());
 					auto vmembuffer = dynamic_cast<MemBuffer*>(vbuffer);
 					auto ibuffer = static_cast<IUniformBuffer*>(meshInstance.meshObject->meshBuffers.indexBuffer.get());
 					auto imembuffer = dynamic_cast<MemBuffer*>(ibuffer);
+					if (vmembuffer->bufferObj != boundVertexBuffer || imembuffer->bufferObj != boundIndexBuffer) {
+						boundVertexBuffer = vmembuffer->bufferObj;
+						boundIndexBuffer = imembuffer->bufferObj;
 
-					VkDeviceSize offset = 0 ; //batch render
-					vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vmembuffer->bufferObj, &offset);
-					//vkCmdBindVertexBuffers(commandBuffer, 1, 1, nullptr, &offset);
-					vkCmdBindIndexBuffer(commandBuffer, imembuffer->bufferObj, 0, VK_INDEX_TYPE_UINT32);
-
-					std::vector<glm::mat4> instanceTransforms;
-					for (const auto& entityInst : meshInstance.instancedMeshEntities) { //ENTITY SPECIFIC 
-						//Mesh Instance & Data Updates :
-						//SAME MATERIAL + SAME MESHES
-
-						auto transform = entityInst->GetComponent<Transform>();
-						transform->bufferModelMatrix->updateBufferData(&transform->getModelMatrix()[0]);
-						auto modelViewDescriptor = gpipeline->getDescriptorSetWrite(transform->bufferModelMatrix.get(), PerMaterialInstance, 2); //<< SetID & DescriptorID need to be dynamic!
-						descriptorSetUpdates.push_back(modelViewDescriptor);
-						//instanceTransforms.push_back(transform->getModelMatrix());
-
-					}//ENTITY SPECIFIC
-
-					//Instanced Entity Transforms Descriptor:
-					//bufferInstanceTransforms = std::make_shared<Vulkan::UniformBuffer>(instanceTransforms.data(), sizeof(glm::mat4), instanceTransforms.size(), BufferStorageDynamic);
-					//auto instancedModelsDescriptor = gpipeline->getDescriptorSetWrite(&bufferInstanceTransforms, PerMaterialInstance, 2); //<< SetID & DescriptorID need to be dynamic!
-					//descriptorSetUpdates.push_back(instancedModelsDescriptor);
-
-					if (descriptorSetUpdates.size() != 0)
-					{
-						vkUpdateDescriptorSets(GraphicsHandler::get()->logicalDevice, descriptorSetUpdates.size(), descriptorSetUpdates.data(), 0, 0);
-						gpipeline->bindDescriptorSets(commandBuffer);
-						vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, gpipeline->pipelineObj);
-
-						//TODO : fix errors below maybe add better syncronisation system for vkUpdateDescriptorSets
-						// 
-						// 14:30:52_329 | Engine | VK_validation layer : Validation Error : [VUID - vkUpdateDescriptorSets - None - 03047] Object 0 : handle = 0xb991fa0000000024, type = VK_OBJECT_TYPE_DESCRIPTOR_SET; | MessageID = 0x35d7ea98 | vkUpdateDescriptorSets() pDescriptorWrites[0] failed write update validation for VkDescriptorSet 0xb991fa0000000024[] with error : Cannot call vkUpdateDescriptorSets() to perform write update on VkDescriptorSet 0xb991fa0000000024[] allocated with VkDescriptorSetLayout 0xc4f3070000000021[] that is in use by a command buffer.The Vulkan spec states : Descriptor bindings updated by this command which were created without the VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT or VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT bits set must not be used by any command that was recorded to a command buffer which is in the pending state(https ://vulkan.lunarg.com/doc/view/1.3.224.1/windows/1.3-extensions/vkspec.html#VUID-vkUpdateDescriptorSets-None-03047)
-						// 14:30:52_330 | Engine | VK_validation layer : Validation Error : [VUID - vkUpdateDescriptorSets - None - 03047] Object 0 : handle = 0xb991fa0000000024, type = VK_OBJECT_TYPE_DESCRIPTOR_SET; | MessageID = 0x35d7ea98 | vkUpdateDescriptorSets() pDescriptorWrites[1] failed write update validation for VkDescriptorSet 0xb991fa0000000024[] with error : Cannot call vkUpdateDescriptorSets() to perform write update on VkDescriptorSet 0xb991fa0000000024[] allocated with VkDescriptorSetLayout 0xc4f3070000000021[] that is in use by a command buffer.The Vulkan spec states : Descriptor bindings updated by this command which were created without the VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT or VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT bits set must not be used by any command that was recorded to a command buffer which is in the pending state(https ://vulkan.lunarg.com/doc/view/1.3.224.1/windows/1.3-extensions/vkspec.html#VUID-vkUpdateDescriptorSets-None-03047)
-						// 14:30:52_331 | Engine | VK_validation layer : Validation Error : [VUID - vkUpdateDescriptorSets - None - 03047] Object 0 : handle = 0xb991fa0000000024, type = VK_OBJECT_TYPE_DESCRIPTOR_SET; | MessageID = 0x35d7ea98 | vkUpdateDescriptorSets() pDescriptorWrites[2] failed write update validation for VkDescriptorSet 0xb991fa0000000024[] with error : Cannot call vkUpdateDescriptorSets() to perform write update on VkDescriptorSet 0xb991fa0000000024[] allocated with VkDescriptorSetLayout 0xc4f3070000000021[] that is in use by a command buffer.The Vulkan spec states : Descriptor bindings updated by this command which were created without the VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT or VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT bits set must not be used by any command that was recorded to a command buffer which is in the pending state(https ://vulkan.lunarg.com/doc/view/1.3.224.1/windows/1.3-extensions/vkspec.html#VUID-vkUpdateDescriptorSets-None-03047) 
-
+						VkDeviceSize offset = 0;
+						vkCmdBindVertexBuffers(commandBuffer, 0, 1, &boundVertexBuffer, &offset);
+						vkCmdBindIndexBuffer(commandBuffer, boundIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
 					}
+				}
 
-					//VkDrawIndexedIndirectCommand drawInstance = {};
-					//drawInstance.firstInstance = 0;
-					//drawInstance.vertexOffset = 0;
-					//drawInstance.indexCount = meshInstance.meshObject->meshData.indexData.size();
-					//drawInstance.instanceCount = meshInstance.instancedMeshEntities.size();
-					//
-					//batchDraws.push_back(drawInstance);
-
-					//gpipeline->bindDescriptorSets(commandBuffer);
-					//vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, gpipeline->pipelineObj);
-					vkCmdDrawIndexed(commandBuffer, meshInstance.meshObject->meshData.indexData.size(), meshInstance.instancedMeshEntities.size(), 0, 0, 0);
-
-					for (auto& var : descriptorSetUpdates)
-					{
-						if (var.pBufferInfo != NULL) {
-							delete(var.pBufferInfo);
-						}
-						if (var.pImageInfo != NULL) {
-							delete(var.pImageInfo);
-						}
-					}
+				firstInstance += meshInstance.instancedMeshEntities.size();
+				previous = &meshInstance;
+				drawIndex++;
+
+			}//MESH INSTANCES
 
-				}//MESH INSTANCES
+			if (drawIndex > runBegin) drawRun(runBegin, drawIndex - runBegin);
 
-				//TODO: on draw indirect indexed, move pipeline and descriptor set binding to here!
-				//UniformBuffer bufferBatchDraws = Vulkan::UniformBuffer(batchDraws.data(), sizeof(VkDrawIndexedIndirectCommand), batchDraws.size(), DrawIndirect);
-				//bufferBatchDraws.updateBufferData(batchDraws.data());
-				//vkCmdDrawIndexedIndirect(commandBuffer, bufferBatchDraws.bufferObj, 0, batchDraws.size(), 0);
+		}//BATCH DRAW
+	}
 
-			}//BATCH DRAW
-			
+	void GraphicsContext::updateSceneLoop() {
+		
+		FrameTime.Stop();
+
+		VkCommandBuffer& commandBuffer = graphicsInstance->swapchain->getCurrentFrameGraphicsCommandBuffer();
+		graphicsInstance->swapchain->beginFrameCommandBuffer(commandBuffer);
+		//streamed textures & buffer ranges uploaded since the last frame change queue ownership before the passes
+		UploadManager::get()->recordAcquireBarriers(commandBuffer, graphicsInstance->swapchain->currentFrame);
+
+		//Instance Transforms & Indirect Draw Commands (shared by all cameras)
+		for (const auto& batchID : sceneGraph->renderBatches) {
+			updateBatchInstances(const_cast<RenderBatch&>(batchID));
+			updateBatchDrawCommands(const_cast<RenderBatch&>(batchID));
 		}
 
-		graphicsInstance->swapchain->endRenderPassCommandBuffer(commandBuffer);
+		//passes are recorded in order with the barriers the graph planned between them
+		renderGraph->execute(commandBuffer, graphicsInstance->swapchain->currentImageIndex);
+
+		graphicsInstance->swapchain->endFrameCommandBuffer(commandBuffer);
 
 		FrameTime.Start();
 
 	}
 
+	void GraphicsContext::recordScenePass(VkCommandBuffer& commandBuffer, const RenderGraphPassContext& context)
+	{
+		//https://computergraphics.stackexchange.com/questions/4499/how-to-change-sampler-pipeline-states-at-runtime-in-vulkan
+		
+		//Traverse Render SceneGraph 
+		for (const auto& cam : sceneGraph->cameras) {
+
+			//SAME CAMERA
+			Camera* camera = cam.camera();
+			glm::mat4 viewProjectionMx = camera->getProjectionMatrix() * cam.transform()->getViewMatrix();
+			RingAllocation viewProjection = frameUniforms->push(&viewProjectionMx[0], sizeof(glm::mat4));
+			if (!viewProjection.isValid()) continue;
+
+			//descriptor sets & shared allocators are resolved on this thread...
+			std::vector<PreparedBatch> preparedBatches;
+			preparedBatches.reserve(sceneGraph->renderBatches.size());
+			for (const auto& batchID : sceneGraph->renderBatches) {
+				PreparedBatch prepared;
+				if (prepareBatch(batchID, viewProjection, prepared)) {
+					preparedBatches.push_back(prepared);
+				}
+			}
+			std::stable_sort(preparedBatches.begin(), preparedBatches.end(), [](const PreparedBatch& a, const PreparedBatch& b) {
+				return a.pipeline->creationIndex < b.pipeline->creationIndex;
+			});
+
+			//...then batches are recorded in parallel, one secondary command buffer per worker range
+			std::vector<VkCommandBuffer> secondaryCommandBuffers(preparedBatches.size(), VK_NULL_HANDLE);
+			VkRenderPass renderPass = context.renderPass;
+			VkFramebuffer framebuffer = context.framebuffer;
+			ThreadPool::get()->parallelFor(0, (uint)preparedBatches.size(), parallelRecordBatchSize, [&](uint begin, uint end) {
+				VkCommandBuffer secondaryCommandBuffer = threadCommandPools->beginSecondaryCommandBuffer(renderPass, framebuffer);
+				recordBatches(secondaryCommandBuffer, preparedBatches, begin, end);
+				threadCommandPools->endSecondaryCommandBuffer(secondaryCommandBuffer);
+				secondaryCommandBuffers[begin] = secondaryCommandBuffer;
+			});
+
+			//keep the batch order
+			secondaryCommandBuffers.erase(std::remove(secondaryCommandBuffers.begin(), secondaryCommandBuffers.end(), VK_NULL_HANDLE), secondaryCommandBuffers.end());
+			if (!secondaryCommandBuffers.empty()) {
+				vkCmdExecuteCommands(commandBuffer, secondaryCommandBuffers.size(), secondaryCommandBuffers.data());
+			}
+		}
+	}
+
+	void GraphicsContext::buildRenderGraph()
+	{
+		SwapChain& swapchain = *graphicsInstance->swapchain;
+		renderGraph->reset();
+
+		std::vector<VkImage> swapchainImages;
+		std::vector<VkImageView> swapchainViews;
+		for (const auto& swapchainImageView : swapchain.swapChainImageViews) {
+			swapchainImages.push_back(swapchainImageView.imageBuffer.imageReference);
+			swapchainViews.push_back(swapchainImageView.imageView);
+		}
+		RenderGraphImageDesc backbufferDesc{ swapchain.swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT };
+		RenderGraphResource backbuffer = renderGraph->importImage("backbuffer", backbufferDesc, swapchainImages, swapchainViews, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+
+		RenderGraphImageDesc depthDesc{ ImageView::findDepthFormat(), VK_IMAGE_ASPECT_DEPTH_BIT };
+		if (depthDesc.format == VK_FORMAT_D32_SFLOAT_S8_UINT || depthDesc.format == VK_FORMAT_D24_UNORM_S8_UINT) {
+			depthDesc.aspectFlags |= VK_IMAGE_ASPECT_STENCIL_BIT;
+		}
+		RenderGraphResource depth = renderGraph->createImage("depth", depthDesc);
+
+		//depth prepasses, shadow maps & post-processing are declared here : barriers & attachment memory come from the graph
+		RenderGraphPass& scenePass = renderGraph->addPass("scene", VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, [this](VkCommandBuffer& commandBuffer, const RenderGraphPassContext& context) {
+			recordScenePass(commandBuffer, context);
+		});
+		scenePass.writeColor(backbuffer);
+		scenePass.writeDepth(depth);
+
+		renderGraph->compile(swapchain.swapChainExtent);
+		GraphicsHandler::get()->setRenderPass(renderGraph->getRenderPass("scene"));
+	}
+
+	void GraphicsContext::recreateSwapChain()
+	{
+		//the graph imports the new images & resizes its attachments
+		if (graphicsInstance->swapchain->recreateSwapChain()) {
+			buildRenderGraph();
+		}
+	}
+
 #pragma endregion
 
 	void GraphicsContext::Draw()
@@ -203,7 +395,13 @@ namespace Comphi::Vulkan {
 		//Submit the recorded command buffer
 		//Present the swap chain image
 
-		vkWaitForFences(graphicsInstance->logicalDevice, 1, &graphicsInstance->swapchain->getCurrentFrameFence(), VK_TRUE, UINT64_MAX);
+		//nothing to present while minimized, no blocking either
+		if (graphicsInstance->swapchain->isMinimized()) return;
+
+		//only the frame submitted framesInFlight frames ago has to be done, the newer ones keep running
+		recordFrameWaitTime(graphicsInstance->swapchain->waitForCurrentFrame());
+		graphicsInstance->swapchain->releaseRetiredSwapChains();
+		DeferredDeletionQueue::get()->beginFrame(graphicsInstance->swapchain->getNextFrameValue(), graphicsInstance->swapchain->getCompletedFrameValue());
 
 		uint32_t imageIndex;
 		VkResult result = vkAcquireNextImageKHR(
@@ -215,23 +413,23 @@ namespace Comphi::Vulkan {
 			&imageIndex //refers to vkGetSwapchainImagesKHR of swapchain ImageViews
 		);
 
-		if (result != VK_SUCCESS) {
-			COMPHILOG_CORE_ERROR("failed to acquireNextImage!");
-			//throw std::runtime_error("failed to acquireNextImage!");
-			if (result == VK_SUBOPTIMAL_KHR) {
-				COMPHILOG_CORE_ERROR("failed to acquire swap chain image!");
-				throw std::runtime_error("failed to acquire swap chain image!");
-			}
+		//suboptimal images are still presented, the swapchain is recreated after the present
+		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+			recreateSwapChain();
+			return;
 		}
-		else {
-			if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-				graphicsInstance->swapchain->recreateSwapChain();
-				return;
-			}
+		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+			COMPHILOG_CORE_FATAL("failed to acquire swap chain image!");
+			throw std::runtime_error("failed to acquire swap chain image!");
 		}
 
-		// Only reset the fence if we are submitting work
-		vkResetFences(graphicsInstance->logicalDevice, 1, &graphicsInstance->swapchain->getCurrentFrameFence());
+		graphicsInstance->swapchain->currentImageIndex = imageIndex;
+
+		//the GPU finished reading this frame's uniforms & descriptor sets
+		frameUniforms->beginFrame(graphicsInstance->swapchain->currentFrame);
+		descriptorAllocator->beginFrame(graphicsInstance->swapchain->currentFrame);
+		threadCommandPools->beginFrame(graphicsInstance->swapchain->currentFrame);
+		UploadManager::get()->beginFrame(graphicsInstance->swapchain->currentFrame);
 
 		//vkResetCommandPool(graphicsInstance->logicalDevice, commandPool->graphicsCommandPool,0); 
 		//if you are making multiple command buffers from one pool, resetting the pool will be quicker.
@@ -244,24 +442,51 @@ namespace Comphi::Vulkan {
 		VkSubmitInfo submitInfo{};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-		VkSemaphore waitSemaphores[] = { graphicsInstance->swapchain->getCurrentFrameAvailableSemaphore()};
-		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = waitSemaphores;
-		submitInfo.pWaitDstStageMask = waitStages;
+		//uploads recorded during the scene update go out as one transfer batch this frame waits on
+		UploadManager::get()->flush();
+		std::vector<VkSemaphore> waitSemaphores = { graphicsInstance->swapchain->getCurrentFrameAvailableSemaphore() };
+		std::vector<VkPipelineStageFlags> waitStages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+		for (VkSemaphore uploadSemaphore : UploadManager::get()->consumeWaitSemaphores(graphicsInstance->swapchain->currentFrame)) {
+			waitSemaphores.push_back(uploadSemaphore);
+			waitStages.push_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+		}
+		submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+		submitInfo.pWaitSemaphores = waitSemaphores.data();
+		submitInfo.pWaitDstStageMask = waitStages.data();
 
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &graphicsInstance->swapchain->getCurrentFrameGraphicsCommandBuffer();
 
-		VkSemaphore signalSemaphores[] = { graphicsInstance->swapchain->getCurrentFrameFinishedSemaphore()};
-		submitInfo.signalSemaphoreCount = 1;
+		//binary semaphore for the present, timeline value for the frame slot
+		uint64_t frameValue = graphicsInstance->swapchain->getNextFrameValue();
+		VkSemaphore signalSemaphores[] = { graphicsInstance->swapchain->getCurrentFrameFinishedSemaphore(), graphicsInstance->swapchain->frameTimeline.semaphoreObj };
+		uint64_t signalValues[] = { 0, frameValue };
+		submitInfo.signalSemaphoreCount = 2;
 		submitInfo.pSignalSemaphores = signalSemaphores;
 
-		if (vkQueueSubmit(graphicsInstance->graphicsQueue, 1, &submitInfo, graphicsInstance->swapchain->getCurrentFrameFence()) != VK_SUCCESS) {
+		std::vector<uint64_t> waitValues(waitSemaphores.size(), 0); //binary semaphores only
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+		timelineInfo.pWaitSemaphoreValues = waitValues.data();
+		timelineInfo.signalSemaphoreValueCount = 2;
+		timelineInfo.pSignalSemaphoreValues = signalValues;
+		submitInfo.pNext = &timelineInfo;
+
+		VkResult submitResult;
+		{
+			//transient & upload submits may run on other threads, possibly on this same queue
+			std::lock_guard<std::mutex> queueLock(GraphicsHandler::get()->getQueueMutex(graphicsInstance->graphicsQueue));
+			submitResult = vkQueueSubmit(graphicsInstance->graphicsQueue, 1, &submitInfo, graphicsInstance->swapchain->getCurrentFrameSubmitFence());
+		}
+		if (submitResult != VK_SUCCESS) {
 			COMPHILOG_CORE_WARN("failed to submit draw command buffer!");
 			//throw std::runtime_error("failed to submit draw command buffer!");
 			//return;
 		}
+		else {
+			graphicsInstance->swapchain->markCurrentFrameSubmitted(frameValue);
+		}
 
 		VkPresentInfoKHR presentInfo{};
 		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -276,7 +501,13 @@ namespace Comphi::Vulkan {
 
 		presentInfo.pResults = nullptr; // Optional error handling
 
-		result = vkQueuePresentKHR(graphicsInstance->presentQueue, &presentInfo);
+		{
+			std::lock_guard<std::mutex> queueLock(GraphicsHandler::get()->getQueueMutex(graphicsInstance->presentQueue));
+			result = vkQueuePresentKHR(graphicsInstance->presentQueue, &presentInfo);
+		}
+		if (submitResult == VK_SUCCESS && (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR)) {
+			graphicsInstance->swapchain->markPresented(frameValue);
+		}
 
 		/* TODO : Fix ImageView Presentation ready-ness on Framebuffer Resize
 		* VK_validation layer: Validation Error: [ VUID-VkPresentInfoKHR-pImageIndices-01296 ] 
@@ -292,7 +523,7 @@ namespace Comphi::Vulkan {
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || _framebufferResized) {
 			_framebufferResized = false;
-			graphicsInstance->swapchain->recreateSwapChain();
+			recreateSwapChain();
 		}
 		else if (result != VK_SUCCESS) {
 			COMPHILOG_CORE_FATAL("failed to present swap chain image!");
@@ -304,10 +535,48 @@ namespace Comphi::Vulkan {
 		//throw std::runtime_error("The End of the World");
 	}
 
+	void GraphicsContext::SetFramesInFlight(uint count)
+	{
+		graphicsInstance->swapchain->setFramesInFlight(count);
+		frameWaitTimeSum = 0.0f;
+		frameWaitTimeCount = 0;
+	}
+
+	void GraphicsContext::SetFrameFenceWait(bool enabled)
+	{
+		graphicsInstance->swapchain->waitOnFrameFences = enabled;
+		frameWaitTimeSum = 0.0f;
+		frameWaitTimeCount = 0;
+	}
+
+	void GraphicsContext::recordFrameWaitTime(float waitTimeMs)
+	{
+		//averaged over frameWaitTimeLogInterval frames, to compare frames in flight settings & fence/timeline waits
+		frameWaitTime = waitTimeMs;
+		frameWaitTimeSum += waitTimeMs;
+		if (++frameWaitTimeCount < frameWaitTimeLogInterval) return;
+
+		COMPHILOG_CORE_INFO("frame CPU wait : {0} ms average ({1} frames in flight, {2})", frameWaitTimeSum / frameWaitTimeCount,
+			graphicsInstance->swapchain->framesInFlight, graphicsInstance->swapchain->waitOnFrameFences ? "fences" : "timeline");
+		frameWaitTimeSum = 0.0f;
+		frameWaitTimeCount = 0;
+	}
+
 	void GraphicsContext::CleanUp()
 	{
 		vkDeviceWaitIdle(graphicsInstance->logicalDevice);
 
+		frameUniforms->cleanUp();
+		descriptorAllocator->cleanUp();
+		threadCommandPools->cleanUp();
+		ImageView::cleanUpPlaceholderTexture();
+		UploadManager::get()->cleanUp();
+		TransientCommandPools::get()->cleanUp();
+		GeometryPool::get()->cleanUp();
+		renderGraph->cleanUp();
+		//device is idle : pending deletions run now, later cleanUps destroy immediately
+		DeferredDeletionQueue::get()->flush();
+
 		//TODO : create Cleanup Stack of all Instanced Engine Objects (send vk objRefs to static queue on creation?)
 		GraphicsHandler::get()->DeleteStatic();
 		graphicsInstance->cleanUp();
@@ -3,6 +3,10 @@
 #include "Comphi/Renderer/Vulkan/GraphicsHandler.h"
 #include "Comphi/Renderer/Vulkan/GraphicsInstance.h"
 #include "Comphi/Renderer/Vulkan/Graphics/GraphicsPipeline.h"
+#include "Comphi/Renderer/Vulkan/Graphics/DescriptorAllocator.h"
+#include "Comphi/Renderer/Vulkan/Graphics/RenderGraph.h"
+#include "Comphi/Renderer/Vulkan/Buffers/FrameRingBuffer.h"
+#include "Comphi/Renderer/Vulkan/Commands/ThreadCommandPools.h"
 #include "Comphi/Utils/Time.h"
 
 namespace Comphi::Vulkan {
@@ -18,16 +22,50 @@ namespace Comphi::Vulkan {
 		virtual void ResizeFramebuffer(uint x, uint y) override;
 		virtual void CleanUp() override;
 
+		//[2, MAX_FRAMES_IN_FLIGHT], can be changed between frames
+		void SetFramesInFlight(uint count);
+		//waits on per frame fences instead of the timeline alone, the before/after baseline of the logged frame CPU wait
+		void SetFrameFenceWait(bool enabled);
+
 		std::unique_ptr<GraphicsInstance> graphicsInstance;
+		std::unique_ptr<FrameRingBuffer> frameUniforms; //per frame shader data (camera...)
+		std::unique_ptr<DescriptorAllocator> descriptorAllocator;
+		std::unique_ptr<ThreadCommandPools> threadCommandPools; //secondary command buffers per worker thread
+		std::unique_ptr<RenderGraph> renderGraph; //frame passes, rebuilt with the swapchain
+
+		//Batches per recording job are at least this many, small scenes are recorded on the calling thread
+		uint parallelRecordBatchSize = 16;
 
 		Time FrameTime; //TODO: Debug ?
+		float frameWaitTime = 0.0f; //ms the CPU blocked on the frame timeline (or fence) this frame
+		uint frameWaitTimeLogInterval = 600;
 		SceneGraphPtr sceneGraph;
 
 	protected:
 		bool _framebufferResized = false;
+		void recordFrameWaitTime(float waitTimeMs);
+		float frameWaitTimeSum = 0.0f;
+		uint frameWaitTimeCount = 0;
 		void createSyncObjects();
 		void createCommandBuffers();
 		void updateSceneLoop();
+		void buildRenderGraph();
+		void recreateSwapChain();
+		void recordScenePass(VkCommandBuffer& commandBuffer, const RenderGraphPassContext& context);
+		//Batch state resolved before the parallel recording (descriptor sets are not thread safe)
+		struct PreparedBatch {
+			const RenderBatch* batch;
+			GraphicsPipeline* pipeline;
+			VkDescriptorSet descriptorSet;
+			std::vector<uint32_t> dynamicOffsets;
+			VkBuffer drawCommands;
+		};
+		bool prepareBatch(const RenderBatch& batchID, const RingAllocation& viewProjection, PreparedBatch& prepared);
+		void recordBatches(VkCommandBuffer& commandBuffer, const std::vector<PreparedBatch>& preparedBatches, uint begin, uint end);
+
+		void updateBatchInstances(RenderBatch& batch);
+		void updateBatchDrawCommands(RenderBatch& batch);
+		void drawIndexedIndirect(VkCommandBuffer& commandBuffer, VkBuffer drawCommands, uint firstDraw, uint drawCount);
 	};
 
 }
\ No newline at end of file
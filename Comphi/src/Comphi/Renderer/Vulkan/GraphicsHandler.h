@@ -2,6 +2,7 @@
 #include <GLFW/glfw3.h>
 #include <GLFW/glfw3native.h>
 #include <vulkan/vulkan_win32.h>
+#include <mutex>
 
 namespace Comphi::Vulkan {
 
@@ -10,12 +11,18 @@ namespace Comphi::Vulkan {
 		DeviceHandler() = default;
 		VkDevice logicalDevice;
 		VkPhysicalDevice physicalDevice;
+		VkPhysicalDeviceFeatures enabledFeatures;
+		VkPhysicalDeviceProperties deviceProperties; //limits (offset alignments...)
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE; //shared by every pipeline creation, persisted by the GraphicsInstance
 		void setDeviceHandler(
 			const VkDevice& logicalDevice,
-			const VkPhysicalDevice& physicalDevice
+			const VkPhysicalDevice& physicalDevice,
+			const VkPhysicalDeviceFeatures& enabledFeatures
 		) {
 			this->logicalDevice =  logicalDevice;
 			this->physicalDevice = physicalDevice;
+			this->enabledFeatures = enabledFeatures;
+			vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
 		}
 	};
 
@@ -26,10 +33,12 @@ namespace Comphi::Vulkan {
 			uint32_t index; //not a pointer
 			VkCommandPool commandPool;
 			VkQueue queue;
+			std::shared_ptr<std::mutex> submitMutex; //shared when both families use the same VkQueue
 		};
 		CommandQueueFamily transferQueueFamily;
 		CommandQueueFamily graphicsQueueFamily;
 		//CommandQueueFamily presentQueueFamily;
+		std::shared_ptr<std::mutex> presentQueueMutex; //present queue distinct from both
 		void setCommandQueues(
 			const uint32_t transferQueueFamilyIndex,
 			const VkQueue transferQueue,
@@ -41,6 +50,17 @@ namespace Comphi::Vulkan {
 
 			this->graphicsQueueFamily.index = graphicsQueueFamilyIndex;
 			this->graphicsQueueFamily.queue = graphicsQueue;
+
+			this->graphicsQueueFamily.submitMutex = std::make_shared<std::mutex>();
+			this->transferQueueFamily.submitMutex = transferQueue == graphicsQueue ? graphicsQueueFamily.submitMutex : std::make_shared<std::mutex>();
+			this->presentQueueMutex = std::make_shared<std::mutex>();
+		}
+
+		//vkQueueSubmit & vkQueuePresentKHR require the VkQueue to be externally synchronized
+		std::mutex& getQueueMutex(VkQueue queue) {
+			if (queue == graphicsQueueFamily.queue) return *graphicsQueueFamily.submitMutex;
+			if (queue == transferQueueFamily.queue) return *transferQueueFamily.submitMutex;
+			return *presentQueueMutex;
 		}
 
 		void setCommandPools(
@@ -71,18 +91,19 @@ namespace Comphi::Vulkan {
 	public:
 		SwapchainHandler() = default;
 		int* MAX_FRAMES_IN_FLIGHT;
-		VkRenderPass* renderPass;
+		VkRenderPass* renderPass; //scene pass of the RenderGraph, pipelines are created against it
 		VkExtent2D* swapChainExtent;
 		void setSwapchainHandler(
-			VkRenderPass& renderPass,
 			int& MAX_FRAMES_IN_FLIGHT,
 			VkExtent2D& swapChainExtent
 
 		) {
-			this->renderPass = &renderPass;
 			this->MAX_FRAMES_IN_FLIGHT = &MAX_FRAMES_IN_FLIGHT;
 			this->swapChainExtent = &swapChainExtent;
 		}
+		void setRenderPass(VkRenderPass& renderPass) {
+			this->renderPass = &renderPass;
+		}
 	};	
 	
 	//TODO: evaluate if possible to make instanced per Vulkan GraphicsContext (MultiGraphicsContext Handler)?
@@ -1,5 +1,6 @@
 #include "cphipch.h"
 #include "GraphicsInstance.h"
+#include "Memory/DeviceMemoryAllocator.h"
 #include <optional>
 #include <set>
 
@@ -19,7 +20,10 @@ namespace Comphi::Vulkan {
 		pickPhysicalDevice();
 		createLogicalDevices();
 
-		GraphicsHandler::get()->setDeviceHandler(logicalDevice, physicalDevice);
+		GraphicsHandler::get()->setDeviceHandler(logicalDevice, physicalDevice, enabledFeatures);
+
+		pipelineCache = std::make_unique<PipelineCache>(pipelineCacheFilePath);
+		GraphicsHandler::get()->pipelineCache = pipelineCache->cacheObj;
 
 		GraphicsHandler::get()->setCommandQueues(
 			queueFamilyIndices.transferFamily.value(),
@@ -34,11 +38,17 @@ namespace Comphi::Vulkan {
 	void GraphicsInstance::cleanUp()
 	{
 		swapchain->cleanUp();
-		swapchain->cleanupRenderPass();
+		swapchain->cleanUpFrameObjects();
 
 		COMPHILOG_CORE_INFO("vkDestroy Surface");
  		vkDestroySurfaceKHR(instance, surface, nullptr);
 
+		DeviceMemoryAllocator::get()->cleanUp();
+
+		pipelineCache->save();
+		pipelineCache->cleanUp();
+		GraphicsHandler::get()->pipelineCache = VK_NULL_HANDLE;
+
 		COMPHILOG_CORE_INFO("vkDestroy Destroy Logical Device");
 		vkDestroyDevice(logicalDevice, nullptr);
 
@@ -81,7 +91,7 @@ namespace Comphi::Vulkan {
 		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 		appInfo.pEngineName = "ComphiEngine";
 		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-		appInfo.apiVersion = VK_API_VERSION_1_0;
+		appInfo.apiVersion = VK_API_VERSION_1_2; //timeline semaphores (1.0/1.1 devices use VK_KHR_timeline_semaphore)
 
 		VkInstanceCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -410,7 +420,19 @@ namespace Comphi::Vulkan {
 		VkPhysicalDeviceFeatures supportedFeatures; //Optimize fetch in device ClassObject
 		vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
 
-		return queueFamilyIndices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy;
+		return queueFamilyIndices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy && supportsTimelineSemaphores(device);
+	}
+
+	bool GraphicsInstance::supportsTimelineSemaphores(VkPhysicalDevice device) {
+		VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+		timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+
+		VkPhysicalDeviceFeatures2 features{};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &timelineFeatures;
+		vkGetPhysicalDeviceFeatures2(device, &features);
+
+		return timelineFeatures.timelineSemaphore == VK_TRUE;
 	}
 
 	bool GraphicsInstance::checkDeviceExtensionSupport(VkPhysicalDevice device) {
@@ -420,7 +442,8 @@ namespace Comphi::Vulkan {
 		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
 		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
 
-		std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+		std::vector<const char*> deviceRequiredExtensions = getRequiredDeviceExtensions(device);
+		std::set<std::string> requiredExtensions(deviceRequiredExtensions.begin(), deviceRequiredExtensions.end());
 
 		for (const auto& extension : availableExtensions) {
 			requiredExtensions.erase(extension.extensionName);
@@ -429,6 +452,18 @@ namespace Comphi::Vulkan {
 		return requiredExtensions.empty();
 	}
 
+	std::vector<const char*> GraphicsInstance::getRequiredDeviceExtensions(VkPhysicalDevice device) {
+		std::vector<const char*> requiredExtensions = deviceExtensions;
+
+		//timeline semaphores are core from 1.2 on
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(device, &deviceProperties);
+		if (deviceProperties.apiVersion < VK_API_VERSION_1_2) {
+			requiredExtensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+		}
+		return requiredExtensions;
+	}
+
 #pragma endregion
 
 #pragma region Logical_Device_Queues
@@ -450,9 +485,15 @@ namespace Comphi::Vulkan {
 			queueCreateInfos.push_back(queueCreateInfo);
 		}
 
+		VkPhysicalDeviceFeatures supportedFeatures;
+		vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
 		VkPhysicalDeviceFeatures deviceFeatures{}; //Default all VK_FALSE
 		deviceFeatures.samplerAnisotropy = VK_TRUE; 
 		deviceFeatures.fillModeNonSolid = VK_TRUE;
+		deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect; //optional, falls back to one indirect draw per command
+		deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance; //optional, falls back to one indirect draw per mesh group
+		enabledFeatures = deviceFeatures;
 
 		VkDeviceCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -461,8 +502,16 @@ namespace Comphi::Vulkan {
 
 		createInfo.pEnabledFeatures = &deviceFeatures;
 
-		createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-		createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+		//frame synchronization runs on a timeline semaphore
+		VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+		timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+		timelineFeatures.timelineSemaphore = VK_TRUE;
+		createInfo.pNext = &timelineFeatures;
+
+		std::vector<const char*> enabledExtensions = getRequiredDeviceExtensions(physicalDevice);
+
+		createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+		createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
 #ifdef NDEBUG_Logger 
 		createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -1,6 +1,7 @@
 #pragma once
 #include "Comphi/Renderer/Vulkan/GraphicsHandler.h"
 #include "SwapChain.h"
+#include "Graphics/PipelineCache.h"
 
 namespace Comphi::Vulkan {
 	class GraphicsInstance
@@ -29,6 +30,7 @@ namespace Comphi::Vulkan {
 		//Logical Device & GRAPHICS QUEUES
 		void createLogicalDevices();
 		VkDevice logicalDevice;
+		VkPhysicalDeviceFeatures enabledFeatures;
 
 		VkQueue graphicsQueue;
 		VkQueue presentQueue;
@@ -39,6 +41,10 @@ namespace Comphi::Vulkan {
 		VkFence transferFence;
 
 		std::unique_ptr<SwapChain> swapchain;
+
+		//Pipeline Cache (loaded at startup, saved on cleanUp)
+		std::unique_ptr<PipelineCache> pipelineCache;
+		const std::string pipelineCacheFilePath = "pipeline.cache";
 	protected:
 
 #ifdef NDEBUG_Logger
@@ -71,6 +77,8 @@ namespace Comphi::Vulkan {
 		//Physical Device
 		bool isDeviceSuitable(VkPhysicalDevice device);
 		bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+		std::vector<const char*> getRequiredDeviceExtensions(VkPhysicalDevice device); //deviceExtensions + VK_KHR_timeline_semaphore below 1.2
+		bool supportsTimelineSemaphores(VkPhysicalDevice device);
 		const std::vector<const char*> deviceExtensions = {
 			VK_KHR_SWAPCHAIN_EXTENSION_NAME
 		};
@@ -2,7 +2,6 @@
 #include "Comphi/Platform/IFileRef.h"
 #include "Comphi/Renderer/Vulkan/Buffers/MemBuffer.h"
 #include "Comphi/Renderer/Vulkan/Commands/CommandPool.h"
-#include "Comphi/Renderer/Vulkan/Sync/SyncObjectsFactory.h"
 
 namespace Comphi::Vulkan {
 
@@ -16,29 +15,28 @@ namespace Comphi::Vulkan {
 	class ImageBuffer
 	{
 	public:
-		void initTextureImageBuffer(IFileRef& fileref, ImageBufferSpecification& specification); //TODO: Add rawData Initialization construct - send pixel Array as input
-		void initDepthImageBuffer(VkExtent2D& swapchainExtent, ImageBufferSpecification& specification);
+		//RGBA8 decode (any thread), returns nullptr on failure, release with freeTextureImageData
+		static unsigned char* loadTextureImageData(const std::string& filePath, VkExtent2D& extent);
+		static void freeTextureImageData(unsigned char* pixels);
+
+		void initTextureImageBuffer(VkExtent2D& extent, ImageBufferSpecification& specification);
+		//stages the pixels on the UploadManager transfer batch, resident once a frame acquired it on the graphics queue
+		void uploadTextureImage(const void* pixels);
 
 		//Memory
-		VkDeviceMemory memoryBuffer;
-		VkImage imageReference;
+		MemoryAllocation allocation;
+		VkImage imageReference = VK_NULL_HANDLE;
 		//Format
 		VkExtent2D imageExtent;
 		VkImageLayout imageLayout;
 		ImageBufferSpecification specification;
+		bool resident = false; //written & read by the rendering thread only
 
 		void cleanUp();
 
 		ImageBuffer() = default;
 	protected :
-		SyncObjectsFactory layoutChangeSyncObjects;
-		VkSemaphore ownershipChangeSemaphore;
-		VkFence layoutChangeFence;
-
 		void allocateImageBuffer();
-		bool hasStencilComponent();
-		void transitionImageLayout(CommandBuffer& commandBuffer, VkImageLayout newLayout, VkAccessFlags accessMask = 0U);
-		void sendBufferToImgBuffer(MemBuffer& srcBuffer, CommandBuffer& commandBuffer);
 	};
 
 
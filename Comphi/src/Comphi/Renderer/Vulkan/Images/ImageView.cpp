@@ -1,13 +1,52 @@
 #include "cphipch.h"
 #include "ImageView.h"
+#include "Comphi/Core/ThreadPool.h"
+#include "Comphi/Renderer/Vulkan/Memory/DeferredDeletionQueue.h"
 
 namespace Comphi::Vulkan {
 
+	static std::unique_ptr<ImageView> placeholderTexture;
+
 	void ImageView::initTextureImageView(IFileRef& fileref, ImageBufferSpecification bufferSpecs)
 	{
-		imageBuffer.initTextureImageBuffer(fileref, bufferSpecs); //todo: make it temp (do we need it when out of scope?)
+		std::string filePath = fileref.getFilePath();
+		streaming = ThreadPool::get()->submitBackground([this, filePath, bufferSpecs]() {
+			VkExtent2D extent;
+			unsigned char* pixels = ImageBuffer::loadTextureImageData(filePath, extent);
+			if (pixels == nullptr) return; //keeps the placeholder
+
+			initTextureImageView(pixels, extent, bufferSpecs);
+			ImageBuffer::freeTextureImageData(pixels);
+		}).share();
+	}
+
+	void ImageView::initTextureImageView(const void* pixels, VkExtent2D extent, ImageBufferSpecification bufferSpecs)
+	{
+		imageBuffer.initTextureImageBuffer(extent, bufferSpecs);
 		allocateImageView();
 		allocateTextureSampler();
+		//last : the view & sampler have to exist once the rendering thread sees the image as resident
+		imageBuffer.uploadTextureImage(pixels);
+	}
+
+	ImageView* ImageView::getBoundTexture()
+	{
+		return isResident() || placeholderTexture == nullptr ? this : placeholderTexture.get();
+	}
+
+	void ImageView::initPlaceholderTexture()
+	{
+		//2x2 mid grey, resident after the first frame acquires it
+		const uint32_t pixels[4] = { 0xFF808080, 0xFF808080, 0xFF808080, 0xFF808080 };
+		placeholderTexture = std::make_unique<ImageView>();
+		placeholderTexture->initTextureImageView(pixels, { 2, 2 });
+	}
+
+	void ImageView::cleanUpPlaceholderTexture()
+	{
+		if (placeholderTexture == nullptr) return;
+		placeholderTexture->cleanUp();
+		placeholderTexture.reset();
 	}
 
 	void ImageView::allocateTextureSampler()
@@ -66,19 +105,6 @@ namespace Comphi::Vulkan {
 		}
 	}
 
-	void ImageView::initDepthImageView(VkExtent2D& swapChainImageBufferExtent)
-	{
-		//DepthImage specification
-		ImageBufferSpecification specification {};
-		imageBuffer.specification.format = findDepthFormat();
-		imageBuffer.specification.aspectFlags = VK_IMAGE_ASPECT_DEPTH_BIT;
-		imageBuffer.specification.tiling = VK_IMAGE_TILING_OPTIMAL;
-		imageBuffer.specification.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-		
-		imageBuffer.initDepthImageBuffer(swapChainImageBufferExtent, specification); //todo: make it temp (do we need it when out of scope?)
-		allocateImageView();
-	}
-
 	void ImageView::allocateImageView()
 	{
 		VkImageViewCreateInfo createInfo{};
@@ -137,17 +163,22 @@ namespace Comphi::Vulkan {
 
 	void ImageView::cleanUp()
 	{
+		if (streaming.valid()) streaming.wait();
+
 		if (imageBuffer.imageReference != VK_NULL_HANDLE && !isSwapchainImage)
 			imageBuffer.cleanUp();
 
-		COMPHILOG_CORE_INFO("vkDestroy Destroy ImageView");
-		vkDestroyImageView(GraphicsHandler::get()->logicalDevice, imageView, nullptr);
-		
-		if (hasTextureSampler) {
-			COMPHILOG_CORE_INFO("vkDestroy Destroy textureSampler");
-			vkDestroySampler(GraphicsHandler::get()->logicalDevice, textureSampler, nullptr);
-		}
-		
+		VkImageView view = imageView;
+		VkSampler sampler = hasTextureSampler ? textureSampler : VK_NULL_HANDLE;
+		DeferredDeletionQueue::get()->enqueue([view, sampler]() {
+			COMPHILOG_CORE_INFO("vkDestroy Destroy ImageView");
+			vkDestroyImageView(GraphicsHandler::get()->logicalDevice, view, nullptr);
+
+			if (sampler != VK_NULL_HANDLE) {
+				COMPHILOG_CORE_INFO("vkDestroy Destroy textureSampler");
+				vkDestroySampler(GraphicsHandler::get()->logicalDevice, sampler, nullptr);
+			}
+		});
 	}
 
 }
\ No newline at end of file
@@ -1,20 +1,33 @@
 #pragma once
 #include "Comphi/Renderer/ITexture.h"
 #include "ImageBufer.h"
+#include <future>
 
 namespace Comphi::Vulkan {
 
 	class ImageView : public ITexture
 	{
 	public:
+		//decoded & uploaded on a worker thread, getBoundTexture() returns the placeholder until it is resident
 		void initTextureImageView(IFileRef& fileref, ImageBufferSpecification bufferSpecs = {});
-		void initDepthImageView(VkExtent2D& swapChainImageBufferExtent);
+		void initTextureImageView(const void* pixels, VkExtent2D extent, ImageBufferSpecification bufferSpecs = {}); //RGBA8
 		static void initSwapchainImageViews(VkSwapchainKHR swapchain, VkFormat SwapchainImageFormat, std::vector<ImageView>& swapchainImageViews);
 
 		virtual void cleanUp() override; //IObject
 
-		VkImageView imageView;
-		VkSampler textureSampler; 
+		static VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
+		static VkFormat findDepthFormat();
+
+		inline bool isResident() const { return imageBuffer.resident; }
+		//this texture or the placeholder while it's still streaming (rendering thread only)
+		ImageView* getBoundTexture();
+
+		//bound in place of textures that are not resident yet, created by the GraphicsContext
+		static void initPlaceholderTexture();
+		static void cleanUpPlaceholderTexture();
+
+		VkImageView imageView = VK_NULL_HANDLE;
+		VkSampler textureSampler = VK_NULL_HANDLE; 
 		//TODO maybe separate sampler from texture 
 		//and use it as a shader resource that can be reused for differernt textures
 		ImageBuffer imageBuffer;
@@ -27,8 +40,7 @@ namespace Comphi::Vulkan {
 		void allocateImageView();
 		bool isSwapchainImage = false;
 		bool hasTextureSampler = false;
-		VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
-		VkFormat findDepthFormat();
+		std::shared_future<void> streaming;
 		
 	};
 
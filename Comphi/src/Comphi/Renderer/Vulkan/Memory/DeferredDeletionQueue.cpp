@@ -0,0 +1,59 @@
+#include "cphipch.h"
+#include "DeferredDeletionQueue.h"
+
+namespace Comphi::Vulkan {
+
+	DeferredDeletionQueue* DeferredDeletionQueue::get()
+	{
+		static DeferredDeletionQueue instance;
+		return &instance;
+	}
+
+	void DeferredDeletionQueue::enqueue(std::function<void()> destroy)
+	{
+		{
+			std::lock_guard<std::mutex> lock(deletionMutex);
+			if (!immediate) {
+				deletions.push_back({ recordingFrameValue, std::move(destroy) });
+				return;
+			}
+		}
+		destroy();
+	}
+
+	void DeferredDeletionQueue::beginFrame(uint64_t recordingValue, uint64_t completedFrameValue)
+	{
+		std::vector<std::function<void()>> retired;
+		{
+			std::lock_guard<std::mutex> lock(deletionMutex);
+			recordingFrameValue = recordingValue;
+
+			//tags only grow, the retired deletions are at the front
+			while (!deletions.empty() && deletions.front().retireValue <= completedFrameValue) {
+				retired.push_back(std::move(deletions.front().destroy));
+				deletions.pop_front();
+			}
+		}
+
+		//outside the lock : a destroy may enqueue further deletions
+		for (auto& destroy : retired) {
+			destroy();
+		}
+	}
+
+	void DeferredDeletionQueue::flush()
+	{
+		std::deque<Deletion> remaining;
+		{
+			std::lock_guard<std::mutex> lock(deletionMutex);
+			immediate = true;
+			remaining.swap(deletions);
+		}
+
+		COMPHILOG_CORE_INFO("DeferredDeletionQueue flushing {0} deletions", remaining.size());
+		for (auto& deletion : remaining) {
+			deletion.destroy();
+		}
+	}
+
+}
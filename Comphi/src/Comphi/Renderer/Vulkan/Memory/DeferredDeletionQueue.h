@@ -0,0 +1,36 @@
+#pragma once
+#include "Comphi/Renderer/Vulkan/GraphicsHandler.h"
+#include <mutex>
+#include <deque>
+
+namespace Comphi::Vulkan {
+
+	//Destroys Vulkan objects once every frame that could still reference them retired on the GPU
+	//Deletions are tagged with the frame timeline value being recorded and run on a later beginFrame()
+	class DeferredDeletionQueue
+	{
+	public:
+		static DeferredDeletionQueue* get();
+
+		//destroy captures the handles by value, runs immediately once flushed (shutdown)
+		void enqueue(std::function<void()> destroy);
+
+		//called after the frame wait : runs the deletions retired by completedFrameValue
+		void beginFrame(uint64_t recordingValue, uint64_t completedFrameValue);
+
+		//device must be idle, runs everything and switches to immediate deletion
+		void flush();
+
+	private:
+		struct Deletion {
+			uint64_t retireValue;
+			std::function<void()> destroy;
+		};
+
+		std::mutex deletionMutex;
+		std::deque<Deletion> deletions;
+		uint64_t recordingFrameValue = 0;
+		bool immediate = false;
+	};
+
+}
@@ -0,0 +1,326 @@
+#include "cphipch.h"
+#include "DeviceMemoryAllocator.h"
+
+namespace Comphi::Vulkan {
+
+	static inline VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	DeviceMemoryAllocator* DeviceMemoryAllocator::get()
+	{
+		static DeviceMemoryAllocator allocator;
+		return &allocator;
+	}
+
+	void DeviceMemoryAllocator::initialize()
+	{
+		vkGetPhysicalDeviceMemoryProperties(GraphicsHandler::get()->physicalDevice, &memoryProperties);
+		pools = std::vector<MemoryPool>(memoryProperties.memoryTypeCount * 2);
+		dedicatedAllocationSupported = GraphicsHandler::get()->deviceProperties.apiVersion >= VK_API_VERSION_1_1;
+		initialized = true;
+	}
+
+	uint DeviceMemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+	{
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+			if ((typeFilter & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+				return i;
+			}
+		}
+		COMPHILOG_CORE_ERROR("failed to find suitable memory type!");
+		throw std::runtime_error("failed to find suitable memory type!");
+	}
+
+	VkDeviceSize DeviceMemoryAllocator::getBlockSize(uint memoryTypeIndex)
+	{
+		//small heaps (host visible device local BAR...) get smaller blocks
+		VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+		return (std::min)(DefaultBlockSize, (std::max)(heapSize / 8, (VkDeviceSize)1024 * 1024));
+	}
+
+	VkDeviceMemory DeviceMemoryAllocator::allocateDeviceMemory(VkDeviceSize size, uint memoryTypeIndex, void*& mappedData, const VkMemoryDedicatedAllocateInfo* dedicatedInfo)
+	{
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.pNext = dedicatedInfo;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+		VkDeviceMemory memory;
+		vkCheckError(vkAllocateMemory(GraphicsHandler::get()->logicalDevice, &allocInfo, nullptr, &memory)) {
+			COMPHILOG_CORE_ERROR("failed to allocate device memory! ({0} bytes, type {1})", size, memoryTypeIndex);
+			throw std::runtime_error("failed to allocate device memory!");
+		}
+		deviceMemoryCount++;
+
+		mappedData = nullptr;
+		if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+			vkCheckError(vkMapMemory(GraphicsHandler::get()->logicalDevice, memory, 0, VK_WHOLE_SIZE, 0, &mappedData)) {
+				COMPHILOG_CORE_ERROR("failed to map device memory!");
+				throw std::runtime_error("failed to map device memory!");
+			}
+		}
+		return memory;
+	}
+
+	bool DeviceMemoryAllocator::allocateFromBlock(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+	{
+		for (size_t i = 0; i < block.freeRanges.size(); i++)
+		{
+			FreeRange range = block.freeRanges[i];
+			VkDeviceSize alignedOffset = alignUp(range.offset, alignment);
+			VkDeviceSize rangeEnd = range.offset + range.size;
+			if (alignedOffset + size > rangeEnd) continue;
+
+			//the alignment padding stays free
+			block.freeRanges.erase(block.freeRanges.begin() + i);
+			if (alignedOffset + size < rangeEnd) {
+				block.freeRanges.insert(block.freeRanges.begin() + i, { alignedOffset + size, rangeEnd - (alignedOffset + size) });
+			}
+			if (alignedOffset > range.offset) {
+				block.freeRanges.insert(block.freeRanges.begin() + i, { range.offset, alignedOffset - range.offset });
+			}
+
+			block.usedSize += size;
+			block.allocationCount++;
+			offset = alignedOffset;
+			return true;
+		}
+		return false;
+	}
+
+	MemoryAllocation DeviceMemoryAllocator::allocateForImage(VkImage image, VkMemoryPropertyFlags properties, ResourceType resourceType)
+	{
+		VkDevice device = GraphicsHandler::get()->logicalDevice;
+		{
+			std::lock_guard<std::mutex> lock(allocatorMutex);
+			if (!initialized) initialize();
+		}
+
+		if (!dedicatedAllocationSupported) {
+			VkMemoryRequirements requirements;
+			vkGetImageMemoryRequirements(device, image, &requirements);
+			return allocate(requirements, properties, resourceType, nullptr, false);
+		}
+
+		VkImageMemoryRequirementsInfo2 requirementsInfo{};
+		requirementsInfo.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+		requirementsInfo.image = image;
+
+		VkMemoryDedicatedRequirements dedicatedRequirements{};
+		dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+		VkMemoryRequirements2 requirements{};
+		requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+		requirements.pNext = &dedicatedRequirements;
+		vkGetImageMemoryRequirements2(device, &requirementsInfo, &requirements);
+
+		VkMemoryDedicatedAllocateInfo dedicatedInfo{};
+		dedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+		dedicatedInfo.image = image;
+		bool prefersDedicated = dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+		return allocate(requirements.memoryRequirements, properties, resourceType, &dedicatedInfo, prefersDedicated);
+	}
+
+	MemoryAllocation DeviceMemoryAllocator::allocateForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties)
+	{
+		VkDevice device = GraphicsHandler::get()->logicalDevice;
+		{
+			std::lock_guard<std::mutex> lock(allocatorMutex);
+			if (!initialized) initialize();
+		}
+
+		if (!dedicatedAllocationSupported) {
+			VkMemoryRequirements requirements;
+			vkGetBufferMemoryRequirements(device, buffer, &requirements);
+			return allocate(requirements, properties, BufferResource, nullptr, false);
+		}
+
+		VkBufferMemoryRequirementsInfo2 requirementsInfo{};
+		requirementsInfo.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+		requirementsInfo.buffer = buffer;
+
+		VkMemoryDedicatedRequirements dedicatedRequirements{};
+		dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+		VkMemoryRequirements2 requirements{};
+		requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+		requirements.pNext = &dedicatedRequirements;
+		vkGetBufferMemoryRequirements2(device, &requirementsInfo, &requirements);
+
+		VkMemoryDedicatedAllocateInfo dedicatedInfo{};
+		dedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+		dedicatedInfo.buffer = buffer;
+		bool prefersDedicated = dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+		return allocate(requirements.memoryRequirements, properties, BufferResource, &dedicatedInfo, prefersDedicated);
+	}
+
+	MemoryAllocation DeviceMemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceType resourceType)
+	{
+		return allocate(requirements, properties, resourceType, nullptr, false);
+	}
+
+	MemoryAllocation DeviceMemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceType resourceType, const VkMemoryDedicatedAllocateInfo* dedicatedInfo, bool prefersDedicated)
+	{
+		std::lock_guard<std::mutex> lock(allocatorMutex);
+		if (!initialized) initialize();
+
+		MemoryAllocation allocation;
+		allocation.memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties);
+		allocation.size = requirements.size;
+		allocation.poolIndex = getPoolIndex(allocation.memoryTypeIndex, resourceType);
+		MemoryPool& pool = pools[allocation.poolIndex];
+
+		//Dedicated (large render targets & textures, or driver preference)
+		VkDeviceSize blockSize = getBlockSize(allocation.memoryTypeIndex);
+		if (prefersDedicated || requirements.size >= (std::min)(DedicatedAllocationSize, blockSize / 2)) {
+			allocation.memory = allocateDeviceMemory(requirements.size, allocation.memoryTypeIndex, allocation.mappedData, dedicatedInfo);
+			allocation.dedicated = true;
+			pool.dedicatedCount++;
+			pool.dedicatedBytes += requirements.size;
+			return allocation;
+		}
+
+		//Sub-allocation (first block with a fitting range)
+		for (auto& block : pool.blocks)
+		{
+			if (block.size - block.usedSize < requirements.size) continue;
+			if (allocateFromBlock(block, requirements.size, requirements.alignment, allocation.offset)) {
+				allocation.memory = block.memory;
+				allocation.mappedData = block.mappedData ? static_cast<char*>(block.mappedData) + allocation.offset : nullptr;
+				return allocation;
+			}
+		}
+
+		MemoryBlock block;
+		block.size = blockSize;
+		block.memory = allocateDeviceMemory(block.size, allocation.memoryTypeIndex, block.mappedData);
+		block.freeRanges.push_back({ 0, block.size });
+		allocateFromBlock(block, requirements.size, requirements.alignment, allocation.offset);
+		pool.blocks.push_back(block);
+
+		COMPHILOG_CORE_INFO("DeviceMemoryAllocator: new {0} MB block (memory type {1}, {2} device memory allocations)", block.size / (1024 * 1024), allocation.memoryTypeIndex, deviceMemoryCount);
+
+		allocation.memory = block.memory;
+		allocation.mappedData = block.mappedData ? static_cast<char*>(block.mappedData) + allocation.offset : nullptr;
+		return allocation;
+	}
+
+	void DeviceMemoryAllocator::free(MemoryAllocation& allocation)
+	{
+		if (!allocation.isValid()) return;
+
+		std::lock_guard<std::mutex> lock(allocatorMutex);
+		if (!initialized) return; //blocks already released by cleanUp
+
+		VkDevice device = GraphicsHandler::get()->logicalDevice;
+		MemoryPool& pool = pools[allocation.poolIndex];
+
+		if (allocation.dedicated) {
+			if (allocation.mappedData != nullptr) vkUnmapMemory(device, allocation.memory);
+			vkFreeMemory(device, allocation.memory, nullptr);
+			deviceMemoryCount--;
+			pool.dedicatedCount--;
+			pool.dedicatedBytes -= allocation.size;
+			allocation = MemoryAllocation();
+			return;
+		}
+
+		auto block = std::find_if(pool.blocks.begin(), pool.blocks.end(), [&](const MemoryBlock& b) { return b.memory == allocation.memory; });
+		if (block == pool.blocks.end()) {
+			COMPHILOG_CORE_ERROR("DeviceMemoryAllocator: freeing memory that is not owned by the allocator!");
+			return;
+		}
+
+		//insert sorted & merge with the neighbouring free ranges
+		auto& ranges = block->freeRanges;
+		auto next = std::lower_bound(ranges.begin(), ranges.end(), allocation.offset, [](const FreeRange& r, VkDeviceSize offset) { return r.offset < offset; });
+		next = ranges.insert(next, { allocation.offset, allocation.size });
+		if (next + 1 != ranges.end() && next->offset + next->size == (next + 1)->offset) {
+			next->size += (next + 1)->size;
+			ranges.erase(next + 1);
+		}
+		if (next != ranges.begin() && (next - 1)->offset + (next - 1)->size == next->offset) {
+			(next - 1)->size += next->size;
+			ranges.erase(next);
+		}
+
+		block->usedSize -= allocation.size;
+		block->allocationCount--;
+
+		//keep one empty block per pool to avoid allocation churn
+		if (block->allocationCount == 0 && pool.blocks.size() > 1) {
+			if (block->mappedData != nullptr) vkUnmapMemory(device, block->memory);
+			vkFreeMemory(device, block->memory, nullptr);
+			deviceMemoryCount--;
+			pool.blocks.erase(block);
+		}
+
+		allocation = MemoryAllocation();
+	}
+
+	std::vector<MemoryPoolStatistics> DeviceMemoryAllocator::getStatistics()
+	{
+		std::lock_guard<std::mutex> lock(allocatorMutex);
+
+		std::vector<MemoryPoolStatistics> statistics;
+		for (uint i = 0; i < pools.size(); i++)
+		{
+			const MemoryPool& pool = pools[i];
+			if (pool.blocks.empty() && pool.dedicatedCount == 0) continue;
+
+			MemoryPoolStatistics poolStatistics;
+			poolStatistics.memoryTypeIndex = i / 2;
+			poolStatistics.images = (i % 2) == ImageResource;
+			poolStatistics.blockCount = (uint)pool.blocks.size();
+			for (const auto& block : pool.blocks) {
+				poolStatistics.blockBytes += block.size;
+				poolStatistics.usedBytes += block.usedSize;
+				poolStatistics.allocationCount += block.allocationCount;
+			}
+			poolStatistics.dedicatedCount = pool.dedicatedCount;
+			poolStatistics.dedicatedBytes = pool.dedicatedBytes;
+			statistics.push_back(poolStatistics);
+		}
+		return statistics;
+	}
+
+	void DeviceMemoryAllocator::logStatistics()
+	{
+		COMPHILOG_CORE_INFO("DeviceMemoryAllocator: {0} device memory allocations (max {1})", deviceMemoryCount, GraphicsHandler::get()->deviceProperties.limits.maxMemoryAllocationCount);
+		for (const auto& pool : getStatistics())
+		{
+			COMPHILOG_CORE_INFO("  memory type {0} {1}: {2} blocks, {3}/{4} KB used by {5} allocations, {6} dedicated ({7} KB)",
+				pool.memoryTypeIndex, pool.images ? "images" : "buffers", pool.blockCount,
+				pool.usedBytes / 1024, pool.blockBytes / 1024, pool.allocationCount,
+				pool.dedicatedCount, pool.dedicatedBytes / 1024);
+		}
+	}
+
+	void DeviceMemoryAllocator::cleanUp()
+	{
+		if (!initialized) return;
+		logStatistics();
+
+		std::lock_guard<std::mutex> lock(allocatorMutex);
+		VkDevice device = GraphicsHandler::get()->logicalDevice;
+		for (auto& pool : pools)
+		{
+			for (auto& block : pool.blocks)
+			{
+				if (block.allocationCount > 0) {
+					COMPHILOG_CORE_ERROR("DeviceMemoryAllocator: {0} allocations still alive on cleanUp!", block.allocationCount);
+				}
+				if (block.mappedData != nullptr) vkUnmapMemory(device, block.memory);
+				vkFreeMemory(device, block.memory, nullptr);
+			}
+			if (pool.dedicatedCount > 0) {
+				COMPHILOG_CORE_ERROR("DeviceMemoryAllocator: {0} dedicated allocations still alive on cleanUp!", pool.dedicatedCount);
+			}
+		}
+		COMPHILOG_CORE_INFO("vkDestroy Destroy device memory blocks");
+		pools.clear();
+		deviceMemoryCount = 0;
+		initialized = false;
+	}
+
+}
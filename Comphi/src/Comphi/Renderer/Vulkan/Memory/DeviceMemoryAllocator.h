@@ -0,0 +1,97 @@
+#pragma once
+#include "Comphi/Renderer/Vulkan/GraphicsHandler.h"
+#include <mutex>
+
+namespace Comphi::Vulkan {
+
+	//Range of a VkDeviceMemory owned by the DeviceMemoryAllocator
+	struct MemoryAllocation {
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		void* mappedData = nullptr; //host visible memory is persistently mapped (already offset)
+		uint memoryTypeIndex = 0;
+		uint poolIndex = 0;
+		bool dedicated = false; //own VkDeviceMemory (VkMemoryDedicatedAllocateInfo when it backs a single image or buffer)
+		inline bool isValid() const { return memory != VK_NULL_HANDLE; }
+	};
+
+	struct MemoryPoolStatistics {
+		uint memoryTypeIndex = 0;
+		bool images = false; //optimal tiling images are kept apart from buffers (bufferImageGranularity)
+		uint blockCount = 0;
+		VkDeviceSize blockBytes = 0;
+		VkDeviceSize usedBytes = 0;
+		uint allocationCount = 0;
+		uint dedicatedCount = 0;
+		VkDeviceSize dedicatedBytes = 0;
+	};
+
+	//Sub-allocates buffers & images from large VkDeviceMemory blocks per memory type (first fit free lists)
+	//keeping the vkAllocateMemory count far below maxMemoryAllocationCount
+	//Resources of DedicatedAllocationSize or more, or that the driver prefers dedicated, get their own VkDeviceMemory
+	class DeviceMemoryAllocator
+	{
+	public:
+		enum ResourceType {
+			BufferResource = 0, //buffers & linear images
+			ImageResource = 1 //optimal tiling images
+		};
+
+		static constexpr VkDeviceSize DefaultBlockSize = 64 * 1024 * 1024;
+		static constexpr VkDeviceSize DedicatedAllocationSize = DefaultBlockSize / 2;
+
+		static DeviceMemoryAllocator* get();
+
+		//memory bound to a single resource : asks the driver whether it prefers a dedicated allocation
+		MemoryAllocation allocateForImage(VkImage image, VkMemoryPropertyFlags properties, ResourceType resourceType = ImageResource);
+		MemoryAllocation allocateForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties);
+		//memory shared by several resources (aliasing), large requests get their own VkDeviceMemory without a dedicated resource
+		MemoryAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceType resourceType = BufferResource);
+		void free(MemoryAllocation& allocation);
+
+		std::vector<MemoryPoolStatistics> getStatistics();
+		void logStatistics();
+		inline uint getDeviceMemoryCount() const { return deviceMemoryCount; }
+
+		//frees every block, resources still alive are logged as leaks
+		void cleanUp();
+
+	private:
+		struct FreeRange {
+			VkDeviceSize offset;
+			VkDeviceSize size;
+		};
+
+		struct MemoryBlock {
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			VkDeviceSize size = 0;
+			VkDeviceSize usedSize = 0;
+			uint allocationCount = 0;
+			void* mappedData = nullptr;
+			std::vector<FreeRange> freeRanges; //sorted by offset, adjacent ranges merged
+		};
+
+		struct MemoryPool {
+			std::vector<MemoryBlock> blocks;
+			uint dedicatedCount = 0;
+			VkDeviceSize dedicatedBytes = 0;
+		};
+
+		void initialize();
+		uint findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+		VkDeviceSize getBlockSize(uint memoryTypeIndex);
+		VkDeviceMemory allocateDeviceMemory(VkDeviceSize size, uint memoryTypeIndex, void*& mappedData, const VkMemoryDedicatedAllocateInfo* dedicatedInfo = nullptr);
+		MemoryAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceType resourceType, const VkMemoryDedicatedAllocateInfo* dedicatedInfo, bool prefersDedicated);
+		bool allocateFromBlock(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+		inline uint getPoolIndex(uint memoryTypeIndex, ResourceType resourceType) const { return memoryTypeIndex * 2 + resourceType; }
+
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		std::vector<MemoryPool> pools; //[memoryType * 2 + ResourceType]
+		uint deviceMemoryCount = 0;
+		bool initialized = false;
+		bool dedicatedAllocationSupported = false; //Vulkan 1.1 (vkGet*MemoryRequirements2 & VkMemoryDedicatedAllocateInfo)
+		std::mutex allocatorMutex;
+	};
+
+}
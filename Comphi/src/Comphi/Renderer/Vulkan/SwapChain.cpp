@@ -6,9 +6,7 @@ namespace Comphi::Vulkan {
 	SwapChain::SwapChain()
 	{
 		createSwapChain();
-		createRenderPass();
-		GraphicsHandler::get()->setSwapchainHandler(renderPassObj, MAX_FRAMES_IN_FLIGHT, swapChainExtent);
-		createFramebuffers();
+		GraphicsHandler::get()->setSwapchainHandler(MAX_FRAMES_IN_FLIGHT, swapChainExtent);
 
 		createFrameSyncObjects();
 		createFrameCommandBuffers();
@@ -18,11 +16,51 @@ namespace Comphi::Vulkan {
 	{
 		imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
 		renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
+		frameSignalValues.resize(MAX_FRAMES_IN_FLIGHT, 0);
 		inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
 
+		//binary semaphores for acquire/present, the timeline replaces the per frame fences
 		inFlightSyncObjectsFactory.createSemaphores(&imageAvailableSemaphores[0], MAX_FRAMES_IN_FLIGHT);
 		inFlightSyncObjectsFactory.createSemaphores(&renderFinishedSemaphores[0], MAX_FRAMES_IN_FLIGHT);
-		inFlightSyncObjectsFactory.createFences(&inFlightFences[0], MAX_FRAMES_IN_FLIGHT, false);
+		inFlightSyncObjectsFactory.createFences(&inFlightFences[0], MAX_FRAMES_IN_FLIGHT, false); //signaled
+		frameTimeline.create();
+	}
+
+	void SwapChain::setFramesInFlight(uint count)
+	{
+		//slots outside of the rotation keep their resources, they are waited on before being used again
+		framesInFlight = std::clamp(count, 2u, (uint)MAX_FRAMES_IN_FLIGHT);
+		currentFrame %= framesInFlight;
+		COMPHILOG_CORE_INFO("frames in flight : {0}", framesInFlight);
+	}
+
+	float SwapChain::waitForCurrentFrame()
+	{
+		auto waitStart = std::chrono::steady_clock::now();
+		if (waitOnFrameFences) {
+			//a slot submitted before the switch has a signaled fence, the timeline wait below covers it
+			vkWaitForFences(GraphicsHandler::get()->logicalDevice, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+		}
+		frameTimeline.wait(frameSignalValues[currentFrame]);
+		return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
+	}
+
+	VkFence SwapChain::getCurrentFrameSubmitFence()
+	{
+		if (!waitOnFrameFences) return VK_NULL_HANDLE;
+		vkResetFences(GraphicsHandler::get()->logicalDevice, 1, &inFlightFences[currentFrame]);
+		return inFlightFences[currentFrame];
+	}
+
+	void SwapChain::markCurrentFrameSubmitted(uint64_t value)
+	{
+		frameTimelineValue = value;
+		frameSignalValues[currentFrame] = value;
+	}
+
+	void SwapChain::waitIdle()
+	{
+		frameTimeline.wait(frameTimelineValue);
 	}
 
 	void Comphi::Vulkan::SwapChain::createFrameCommandBuffers()
@@ -34,7 +72,7 @@ namespace Comphi::Vulkan {
 		inFlightCommandsPool.allocateTransferCommandBuffer(&transferCommandBuffers[0], transferCommandBuffers.size());
 	}
 
-	void SwapChain::createSwapChain() {
+	void SwapChain::createSwapChain(VkSwapchainKHR oldSwapChain) {
 
 		COMPHILOG_CORE_TRACE("Creating Swapchain...");
 		SwapChainSupportDetails swapChainSupport = querySwapChainSupport(GraphicsHandler::get()->physicalDevice, GraphicsHandler::get()->surface);
@@ -86,8 +124,8 @@ namespace Comphi::Vulkan {
 		createInfo.presentMode = presentMode;
 		createInfo.clipped = VK_TRUE; // ignore color of obscured pixels (another window)
 
-		createInfo.oldSwapchain = VK_NULL_HANDLE;
-		//swap chain becomes invalid if window was resized
+		//swap chain becomes invalid if window was resized, the old one lets the driver reuse its resources
+		createInfo.oldSwapchain = oldSwapChain;
 
 		vkCheckError(vkCreateSwapchainKHR(GraphicsHandler::get()->logicalDevice, &createInfo, nullptr, &swapChainObj)) {
 			COMPHILOG_CORE_FATAL("failed to create swap chain!");
@@ -98,61 +136,72 @@ namespace Comphi::Vulkan {
 
 		//CREATE IMAGE VIEWS
 		ImageView::initSwapchainImageViews(swapChainObj, swapChainImageFormat, swapChainImageViews);
-		swapChainDepthView.initDepthImageView(swapChainExtent);
 	}
 
-	void SwapChain::recreateSwapChain() {
-
-		//TODO: It is possible to create a new swap chain while drawing commands on an image from the old swap chain are still in-flight. 
-		//You need to pass the previous swap chain to the oldSwapChain field in the VkSwapchainCreateInfoKHR struct and destroy the old swap chain as soon as you've finished using it.
-		
+	bool SwapChain::isMinimized()
+	{
 		int width = 0, height = 0;
 		glfwGetFramebufferSize(GraphicsHandler::get()->windowHandle, &width, &height);
-		while (width == 0 || height == 0) {
-			glfwGetFramebufferSize(GraphicsHandler::get()->windowHandle, &width, &height);
-			glfwWaitEvents();
-		}
-
-		vkWaitForFences(GraphicsHandler::get()->logicalDevice, inFlightFences.size(), inFlightFences.data(), VK_TRUE, UINT64_MAX);
-		currentFrame = 0;
-		
-		//TODO: SyncFrames with swapchain recreate operation
-		//waitsignal of swapchainRecreationSyncSemaphore ?
-		
-		/* VkSemaphoreWaitInfo waitInfo = {};
-        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
-        waitInfo.semaphoreCount = renderFinishedSemaphores.size();
-		VkSemaphore* waitSemaphores = renderFinishedSemaphores.data();
-        waitInfo.pSemaphores = waitSemaphores;
-		std::vector<uint64_t> semaphoreWaitValues = std::vector<uint64_t>(waitInfo.semaphoreCount);
-		for (i = 0; i < (waitInfo.semaphoreCount; i++)
-		
-        waitInfo.pValues = semaphoreWaitValues;
-        vkWaitSemaphores(GraphicsHandler::get()->logicalDevice, &waitInfo, UINT64_MAX);*/
-
-		//vkDeviceWaitIdle(GraphicsHandler::get()->logicalDevice); 
-		//using Semaphores to syncronise end of frame with swap operation prolly help, followed by destruction of old Swapchain (below)
-
-		cleanUp();
-		createSwapChain();
-		createFramebuffers();
+		return width == 0 || height == 0;
 	}
 
-	void SwapChain::cleanUp() {
+	bool SwapChain::recreateSwapChain() {
+
+		//minimized : keep the current swapchain, frames are skipped until the window is restored
+		if (isMinimized()) return false;
+
+		//frames in flight keep rendering & presenting to the old images, it is retired after the new one presented (markPresented)
+		RetiredSwapChain retired;
+		retired.swapChainObj = swapChainObj;
+		retired.imageViews = std::move(swapChainImageViews);
+
+		swapChainImageViews.clear();
 
-		for (int i = 0; i < swapChainFramebuffers.size(); i++) {
-			COMPHILOG_CORE_INFO("vkDestroy Destroy framebuffer {0}", i);
-			vkDestroyFramebuffer(GraphicsHandler::get()->logicalDevice, swapChainFramebuffers[i], nullptr);
+		createSwapChain(retired.swapChainObj);
+
+		retiredSwapChains.push_back(std::move(retired));
+		return true;
+	}
+
+	void SwapChain::releaseRetiredSwapChains()
+	{
+		if (retiredSwapChains.empty()) return;
+
+		uint64_t completedValue = frameTimeline.getCompletedValue();
+		while (!retiredSwapChains.empty() && retiredSwapChains.front().retireValue <= completedValue)
+		{
+			RetiredSwapChain& retired = retiredSwapChains.front();
+			destroySwapChainObjects(retired.swapChainObj, retired.imageViews);
+			retiredSwapChains.pop_front();
 		}
+	}
 
-		for (int i = 0; i < swapChainImageViews.size(); i++) {
-			swapChainImageViews[i].cleanUp();
+	void SwapChain::markPresented(uint64_t frameValue)
+	{
+		for (auto& retired : retiredSwapChains) {
+			if (retired.retireValue == UINT64_MAX) retired.retireValue = frameValue;
 		}
+	}
 
-		swapChainDepthView.cleanUp();
+	void SwapChain::destroySwapChainObjects(VkSwapchainKHR swapchain, std::vector<ImageView>& imageViews)
+	{
+		for (int i = 0; i < imageViews.size(); i++) {
+			imageViews[i].cleanUp();
+		}
 
 		COMPHILOG_CORE_INFO("vkDestroy Destroy Swapchain:");
-		vkDestroySwapchainKHR(GraphicsHandler::get()->logicalDevice, swapChainObj, nullptr);
+		vkDestroySwapchainKHR(GraphicsHandler::get()->logicalDevice, swapchain, nullptr);
+	}
+
+	void SwapChain::cleanUp() {
+
+		waitIdle();
+		//device is idle : retired swapchains go even if nothing was presented after them
+		for (auto& retired : retiredSwapChains) {
+			destroySwapChainObjects(retired.swapChainObj, retired.imageViews);
+		}
+		retiredSwapChains.clear();
+		destroySwapChainObjects(swapChainObj, swapChainImageViews);
 	}
 
 
@@ -224,118 +273,12 @@ namespace Comphi::Vulkan {
 		}
 	}
 
-	void SwapChain::createFramebuffers() {
-		if(swapChainFramebuffers.size() < swapChainImageViews.size()){
-			swapChainFramebuffers.resize(swapChainImageViews.size());
-		}
-
-		for (size_t i = 0; i < swapChainImageViews.size(); i++) {
-			std::array<VkImageView, 2> attachments = {
-				swapChainImageViews[i].imageView,
-				swapChainDepthView.imageView
-			};
-
-			VkFramebufferCreateInfo framebufferInfo{};
-			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-			framebufferInfo.renderPass = renderPassObj;
-			framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-			framebufferInfo.pAttachments = attachments.data();
-			framebufferInfo.width = swapChainExtent.width;
-			framebufferInfo.height = swapChainExtent.height;
-			framebufferInfo.layers = 1;
-
-			vkCheckError(vkCreateFramebuffer(GraphicsHandler::get()->logicalDevice, &framebufferInfo, nullptr, &swapChainFramebuffers[i])) {
-				COMPHILOG_CORE_FATAL("failed to create framebuffer!");
-				throw std::runtime_error("failed to create framebuffer!");
-				return;
-			}
-			COMPHILOG_CORE_INFO("created framebuffer of imageView {0}!",i);
-		}
-	}
-
-
-
-	void SwapChain::createRenderPass()
-	{
-		//VkImage Render Attatchments
-		//ColorAttachment
-		VkAttachmentDescription colorAttachment{};
-		colorAttachment.format = swapChainImageFormat;
-		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-
-		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-
-		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-
-		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-		//DepthAttachment
-		VkAttachmentDescription depthAttachment{};
-		depthAttachment.format = swapChainDepthView.imageBuffer.specification.format;
-		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-		//SubPasses
-		VkAttachmentReference colorAttachmentRef{};
-		colorAttachmentRef.attachment = 0;
-		colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		VkAttachmentReference depthAttachmentRef{};
-		depthAttachmentRef.attachment = 1;
-		depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-		VkSubpassDescription subpass{};
-		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-		subpass.colorAttachmentCount = 1;
-		subpass.pColorAttachments = &colorAttachmentRef;
-		subpass.pDepthStencilAttachment = &depthAttachmentRef;
-
-		//RenderPass
-		std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
-		VkRenderPassCreateInfo renderPassInfo{};
-		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-		renderPassInfo.pAttachments = attachments.data();
-		renderPassInfo.subpassCount = 1;
-		renderPassInfo.pSubpasses = &subpass;
-
-		//RenderPass Dependency
-		VkSubpassDependency dependency{};
-		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-		dependency.dstSubpass = 0;
-
-		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-		dependency.srcAccessMask = 0;
-		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
-		renderPassInfo.dependencyCount = 1;
-		renderPassInfo.pDependencies = &dependency;
-
-		if (vkCreateRenderPass(GraphicsHandler::get()->logicalDevice, &renderPassInfo, nullptr, &renderPassObj) != VK_SUCCESS) {
-			COMPHILOG_CORE_FATAL("failed to create render pass!");
-			throw std::runtime_error("failed to create render pass!");
-			return;
-		}
-
-		COMPHILOG_CORE_INFO("created RenderPass Successfully!");
-
-	}
-
 	void SwapChain::incrementSwapChainFrame()
 	{
-		currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+		currentFrame = (currentFrame + 1) % framesInFlight;
 	}
 
-	void SwapChain::beginRenderPassCommandBuffer(VkCommandBuffer& commandBuffer)
+	void SwapChain::beginFrameCommandBuffer(VkCommandBuffer& commandBuffer)
 	{
 		VkCommandBufferBeginInfo beginInfo{};
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -348,44 +291,16 @@ namespace Comphi::Vulkan {
 			throw std::runtime_error("failed to begin recording command buffer!");
 			return;
 		}
-
-		//graphics pipeline & render attachment(framebuffer/img) selection 
-		VkRenderPassBeginInfo renderPassInfo{};
-		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = renderPassObj;
-		renderPassInfo.framebuffer = swapChainFramebuffers[currentFrame];
-		renderPassInfo.renderArea.offset = { 0, 0 };
-		renderPassInfo.renderArea.extent = swapChainExtent;
-
-		std::array<VkClearValue, 2> clearValues{}; //same order as attachments
-		clearValues[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
-		clearValues[1].depthStencil = { 1.0f, 0 };
-
-		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-		renderPassInfo.pClearValues = clearValues.data();
-
-		//TODO: check it out later :https://zeux.io/2020/02/27/writing-an-efficient-vulkan-renderer/
-
-		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
 	}
 
-	void Comphi::Vulkan::SwapChain::endRenderPassCommandBuffer(VkCommandBuffer& commandBuffer)
+	void Comphi::Vulkan::SwapChain::endFrameCommandBuffer(VkCommandBuffer& commandBuffer)
 	{
-		vkCmdEndRenderPass(commandBuffer);
-
 		//EndRecordingCommandBuffer
 		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
 			COMPHILOG_CORE_FATAL("failed to record command buffer!");
 			throw std::runtime_error("failed to record command buffer!");
 			return;
 		}
-
-	}
-
-	VkFence& Comphi::Vulkan::SwapChain::getCurrentFrameFence()
-	{
-		return inFlightFences[currentFrame];
 	}
 
 	VkSemaphore& Comphi::Vulkan::SwapChain::getCurrentFrameAvailableSemaphore()
@@ -408,12 +323,10 @@ namespace Comphi::Vulkan {
 		return transferCommandBuffers[currentFrame];
 	}
 
-	void SwapChain::cleanupRenderPass()
+	void SwapChain::cleanUpFrameObjects()
 	{
 		inFlightSyncObjectsFactory.cleanup();
+		frameTimeline.cleanUp();
 		inFlightCommandsPool.cleanUp();
-
-		COMPHILOG_CORE_INFO("vkDestroy Destroy RenderPass");
-		vkDestroyRenderPass(GraphicsHandler::get()->logicalDevice, renderPassObj, nullptr);
 	}
 }
@@ -1,6 +1,8 @@
 #pragma once
 #include "Comphi/Renderer/Vulkan/Images/ImageView.h"
 #include "Comphi/Renderer/Vulkan/Sync/SyncObjectsFactory.h"
+#include "Comphi/Renderer/Vulkan/Sync/TimelineSemaphore.h"
+#include <deque>
 #include "Comphi/Renderer/Vulkan/Commands/CommandPool.h"
 
 namespace Comphi::Vulkan {
@@ -15,29 +17,50 @@ namespace Comphi::Vulkan {
 	{
 	public:
 		SwapChain();
-		void recreateSwapChain();
+		//builds the new swapchain from the old one without waiting, the old one is released once its frames retired
+		//false while minimized (nothing was recreated)
+		bool recreateSwapChain();
+		bool isMinimized();
+		//destroys the retired swapchains whose retire frame finished on the GPU
+		void releaseRetiredSwapChains();
+		//after swapChainObj presented the frame of value : presents are queued in order, the swapchains retired
+		//before it can go once that frame completes (their own last present is not tracked by the timeline)
+		void markPresented(uint64_t frameValue);
 		void cleanUp();
-		void cleanupRenderPass();
+		void cleanUpFrameObjects();
 		static SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface);
 
 		VkSwapchainKHR swapChainObj;
 		VkFormat swapChainImageFormat;
 		VkExtent2D swapChainExtent;
 		
-		std::vector<ImageView> swapChainImageViews;
-		ImageView swapChainDepthView;
-
-		std::vector<VkFramebuffer> swapChainFramebuffers;
-		VkRenderPass renderPassObj;
+		std::vector<ImageView> swapChainImageViews; //attachments of the RenderGraph (depth & render passes live there)
 
 		void incrementSwapChainFrame();
-		int MAX_FRAMES_IN_FLIGHT = 3; //triple-buffering
+		int MAX_FRAMES_IN_FLIGHT = 4; //per frame resources are sized for the deepest setting
+		uint framesInFlight = 3; //frames rotated at runtime [2, MAX_FRAMES_IN_FLIGHT]
 		uint32_t currentFrame = 0;
+		uint32_t currentImageIndex = 0; //acquired swapchain image
+
+		void setFramesInFlight(uint count);
+
+		//Frame timeline : every frame submit signals the next value
+		//blocks until the GPU finished the last submit of the current frame slot, returns the CPU wait in ms
+		float waitForCurrentFrame();
+		uint64_t getNextFrameValue() const { return frameTimelineValue + 1; }
+		void markCurrentFrameSubmitted(uint64_t value);
+		uint64_t getCompletedFrameValue() { return frameTimeline.getCompletedValue(); }
+		void waitIdle(); //every submitted frame
+		TimelineSemaphore frameTimeline;
 
-		void beginRenderPassCommandBuffer(VkCommandBuffer& commandBuffer);
-		void endRenderPassCommandBuffer(VkCommandBuffer& commandBuffer);
+		//baseline of the CPU wait comparison : waits on per frame fences (the path the timeline replaced)
+		//the timeline is still signaled & waited on, so switching between frames is safe
+		bool waitOnFrameFences = false;
+		VkFence getCurrentFrameSubmitFence(); //reset for the frame submit, VK_NULL_HANDLE unless waitOnFrameFences
+
+		void beginFrameCommandBuffer(VkCommandBuffer& commandBuffer);
+		void endFrameCommandBuffer(VkCommandBuffer& commandBuffer);
 
-		VkFence& getCurrentFrameFence();
 		VkSemaphore& getCurrentFrameAvailableSemaphore();
 		VkSemaphore& getCurrentFrameFinishedSemaphore();
 
@@ -51,15 +74,24 @@ namespace Comphi::Vulkan {
 
 		std::vector<VkSemaphore> imageAvailableSemaphores;
 		std::vector<VkSemaphore> renderFinishedSemaphores;
-		std::vector<VkFence> inFlightFences;
+		std::vector<uint64_t> frameSignalValues; //[frame] timeline value of its last submit
+		std::vector<VkFence> inFlightFences; //only submitted with waitOnFrameFences
+		uint64_t frameTimelineValue = 0; //last submitted value
 
 		void createFrameCommandBuffers();
 		std::vector<VkCommandBuffer> graphicsCommandBuffers;
 		std::vector<VkCommandBuffer> transferCommandBuffers;
 
-		void createRenderPass();
-		void createFramebuffers();
-		void createSwapChain();
+		//Swapchain objects that may still be in use by frames in flight
+		struct RetiredSwapChain {
+			VkSwapchainKHR swapChainObj;
+			std::vector<ImageView> imageViews;
+			uint64_t retireValue = UINT64_MAX; //first frame presented by a newer swapchain, unknown until then
+		};
+		std::deque<RetiredSwapChain> retiredSwapChains;
+		void destroySwapChainObjects(VkSwapchainKHR swapchain, std::vector<ImageView>& imageViews);
+
+		void createSwapChain(VkSwapchainKHR oldSwapChain = VK_NULL_HANDLE);
 		VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
 		VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
 		VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
@@ -0,0 +1,66 @@
+#include "cphipch.h"
+#include "TimelineSemaphore.h"
+
+namespace Comphi::Vulkan {
+
+	void TimelineSemaphore::create(uint64_t initialValue)
+	{
+		VkDevice device = GraphicsHandler::get()->logicalDevice;
+
+		//core entry points on 1.2 devices, the KHR ones otherwise (same signatures)
+		waitSemaphores = (PFN_vkWaitSemaphores)vkGetDeviceProcAddr(device, "vkWaitSemaphores");
+		getSemaphoreCounterValue = (PFN_vkGetSemaphoreCounterValue)vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValue");
+		if (waitSemaphores == nullptr || getSemaphoreCounterValue == nullptr) {
+			waitSemaphores = (PFN_vkWaitSemaphores)vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR");
+			getSemaphoreCounterValue = (PFN_vkGetSemaphoreCounterValue)vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR");
+		}
+		if (waitSemaphores == nullptr || getSemaphoreCounterValue == nullptr) {
+			COMPHILOG_CORE_FATAL("timeline semaphores are not supported!");
+			throw std::runtime_error("timeline semaphores are not supported!");
+		}
+
+		VkSemaphoreTypeCreateInfo typeInfo{};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue = initialValue;
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &typeInfo;
+
+		vkCheckError(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphoreObj)) {
+			COMPHILOG_CORE_FATAL("failed to create timeline semaphore!");
+			throw std::runtime_error("failed to create timeline semaphore!");
+		}
+		COMPHILOG_CORE_INFO("created timeline semaphore!");
+	}
+
+	void TimelineSemaphore::wait(uint64_t value)
+	{
+		if (value == 0) return;
+
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &semaphoreObj;
+		waitInfo.pValues = &value;
+		waitSemaphores(GraphicsHandler::get()->logicalDevice, &waitInfo, UINT64_MAX);
+	}
+
+	uint64_t TimelineSemaphore::getCompletedValue()
+	{
+		uint64_t value = 0;
+		getSemaphoreCounterValue(GraphicsHandler::get()->logicalDevice, semaphoreObj, &value);
+		return value;
+	}
+
+	void TimelineSemaphore::cleanUp()
+	{
+		if (semaphoreObj == VK_NULL_HANDLE) return;
+
+		COMPHILOG_CORE_INFO("vkDestroy Destroy timeline semaphore");
+		vkDestroySemaphore(GraphicsHandler::get()->logicalDevice, semaphoreObj, nullptr);
+		semaphoreObj = VK_NULL_HANDLE;
+	}
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "Comphi/Renderer/Vulkan/GraphicsHandler.h"
+
+namespace Comphi::Vulkan {
+
+	//Monotonic GPU counter (Vulkan 1.2 or VK_KHR_timeline_semaphore)
+	//Submits signal increasing values, the CPU waits for / polls a value instead of per-frame fences
+	class TimelineSemaphore
+	{
+	public:
+		TimelineSemaphore() = default;
+
+		void create(uint64_t initialValue = 0);
+		void cleanUp();
+
+		//blocks until the GPU reached value
+		void wait(uint64_t value);
+		//last value signaled by the GPU
+		uint64_t getCompletedValue();
+		inline bool isComplete(uint64_t value) { return value <= getCompletedValue(); }
+
+		VkSemaphore semaphoreObj = VK_NULL_HANDLE;
+
+	private:
+		PFN_vkWaitSemaphores waitSemaphores = nullptr;
+		PFN_vkGetSemaphoreCounterValue getSemaphoreCounterValue = nullptr;
+	};
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+namespace Comphi {
+
+	//Minimal microbenchmark helper, best of N samples is logged to the core logger
+	class Benchmark
+	{
+	public:
+		//fn(iterations) returns a value that is folded into a sink so the work is not optimized out
+		template<typename Fn>
+		static double run(const std::string& name, uint iterations, Fn&& fn, uint samples = 5);
+
+	private:
+		static inline volatile uint64 sink = 0;
+	};
+
+	template<typename Fn>
+	double Benchmark::run(const std::string& name, uint iterations, Fn&& fn, uint samples)
+	{
+		double best = (std::numeric_limits<double>::max)();
+		for (uint i = 0; i < samples; i++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			sink = sink + (uint64)fn(iterations);
+			auto stop = std::chrono::high_resolution_clock::now();
+			best = (std::min)(best, std::chrono::duration<double, std::nano>(stop - start).count() / iterations);
+		}
+		COMPHILOG_CORE_INFO("[Benchmark] {0}: {1:.3f} ns/op ({2} ops)", name, best, iterations);
+		return best;
+	}
+
+}
@@ -8,6 +8,7 @@
 #include <functional>
 #include <chrono>
 #include <cstdint> // Necessary for uint32_t
+#include <cstring> // Necessary for memcpy
 #include <limits> // Necessary for std::numeric_limits
 
 #include <string>
@@ -16,6 +17,8 @@
 #include <sstream>
 
 #include <vector>
+#include <array>
+#include <tuple>
 #include <stack>
 #include <map>
 #include <set>
@@ -7,8 +7,14 @@ layout(set = 2, binding = 1) uniform sampler2D texSampler;
 
 layout(location = 0) out vec4 outColor;
 
+//Material::setSpecializationConstant(ShaderType::FragmentShader, 0, ...)
+layout(constant_id = 0) const bool useTexture = true;
+
 void main() {
-    //outColor = vec4(fragColor, 1.0);
     //outColor = vec4(fragTexCoord, 0.0, 1.0);
-    outColor = texture(texSampler, fragTexCoord);
+    if (useTexture) {
+        outColor = texture(texSampler, fragTexCoord);
+    } else {
+        outColor = vec4(fragColor, 1.0);
+    }
 }
\ No newline at end of file
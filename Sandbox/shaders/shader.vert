@@ -11,23 +11,21 @@ layout(set = 2, binding = 0) uniform UniformBuffer0 {
     mat4 data;
 } viewProjectionMx;
 
-layout(set = 2, binding = 2) uniform UniformBuffer1{
-    mat4 data;
-} modelMx;
-
-
-/*
-layout(set = 2, binding = 2) readonly buffer StorageBuffer0{
+//model matrix of every instance of the batch
+layout(std430, set = 2, binding = 2) readonly buffer StorageBuffer0{
     mat4 data[];
 } modelMx;
-*/
+
+//written before every indirect draw run, gl_InstanceIndex is relative to the run
+layout(push_constant) uniform DrawPushConstants {
+    uint instanceBase;
+} draw;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
 
 void main() {
-    //gl_Position = viewProjectionMx.data * modelMx.data[gl_InstanceIndex] * vec4(inPosition, 1.0);
-    gl_Position = viewProjectionMx.data * modelMx.data * vec4(inPosition, 1.0);
+    gl_Position = viewProjectionMx.data * modelMx.data[draw.instanceBase + uint(gl_InstanceIndex)] * vec4(inPosition, 1.0);
     fragColor = inColor;
     fragTexCoord = inTexCoord;
 }
\ No newline at end of file
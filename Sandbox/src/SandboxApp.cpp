@@ -46,16 +46,23 @@ GameSceneLayer::GameSceneLayer() : Layer("GameSceneLayer") {
 	fragShader = ComphiAPI::CreateObject::Shader(ShaderType::FragmentShader, frag);
 	
 	//Material / Graphics Pipeline
-	simpleMaterial = ComphiAPI::CreateObject::Material();
-	simpleMaterial->addDefaultVertexBindingDescription();
-	simpleMaterial->createShaderResourceLayoutSetDescriptorSetBinding(PerMaterialInstance, 0, 1, UniformBufferData); //Camera ViewProjectionMatrix (& Lights)
-	simpleMaterial->createShaderResourceLayoutSetDescriptorSetBinding(PerMaterialInstance, 1, 1, ImageBufferSampler, ShaderStageFlag::FragmentStage); //Textures
-	simpleMaterial->createShaderResourceLayoutSetDescriptorSetBinding(PerMaterialInstance, 2, 1, UniformBufferData); //Mesh & ModelMatrix 
-	simpleMaterial->addShader(vertShader);
-	simpleMaterial->addShader(fragShader);
-	simpleMaterial->configuration.rasterizerSettings.cullMode = CullingMode::BackCulling;
-	simpleMaterial->configuration.rasterizerSettings.polygonRenderMode = PolygonMode::PolygonFill;
-	simpleMaterial->initialize();
+	auto createSimpleMaterial = [this](bool useTexture) {
+		MaterialPtr material = ComphiAPI::CreateObject::Material();
+		material->addDefaultVertexBindingDescription();
+		material->createShaderResourceLayoutSetDescriptorSetBinding(PerMaterialInstance, 0, 1, UniformBufferDynamic); //Camera ViewProjectionMatrix (& Lights)
+		material->createShaderResourceLayoutSetDescriptorSetBinding(PerMaterialInstance, 1, 1, ImageBufferSampler, ShaderStageFlag::FragmentStage); //Textures
+		material->createShaderResourceLayoutSetDescriptorSetBinding(PerMaterialInstance, 2, 1, StorageBufferData); //Instanced ModelMatrices 
+		material->addShader(vertShader);
+		material->addShader(fragShader);
+		material->setSpecializationConstant(ShaderType::FragmentShader, 0, useTexture); //shader.frag useTexture
+		material->configuration.rasterizerSettings.cullMode = CullingMode::BackCulling;
+		material->configuration.rasterizerSettings.polygonRenderMode = PolygonMode::PolygonFill;
+		material->initialize();
+		return material;
+	};
+	simpleMaterial = createSimpleMaterial(true);
+	//same configuration but the specialization constant : its own pipeline variant, kept alive by its instances
+	MaterialPtr vertexColorMaterial = createSimpleMaterial(false);
 	
 	//Mesh 1
 	modelMeshA = Windows::FileRef("models/viking_room.obj");
@@ -74,19 +81,19 @@ GameSceneLayer::GameSceneLayer() : Layer("GameSceneLayer") {
 	AlbedoA = ComphiAPI::CreateObject::MaterialInstance(simpleMaterial);
 	AlbedoA->bindTexture(texture, PerMaterialInstance, 1);
 
-	AlbedoB = ComphiAPI::CreateObject::MaterialInstance(simpleMaterial);
-	AlbedoB->bindTexture(texture2, PerMaterialInstance, 1);
+	AlbedoB = ComphiAPI::CreateObject::MaterialInstance(vertexColorMaterial);
+	AlbedoB->bindTexture(texture2, PerMaterialInstance, 1); //not sampled, the set layout still has the binding
 	
 	gameObjA = ComphiAPI::CreateObject::Entity();
-	auto& transformComponent = gameObjA->AddComponent(ComphiAPI::CreateComponent::Transform());
+	auto transformComponent = gameObjA->AddComponent(ComphiAPI::CreateComponent::Transform());
 	gameObjA->AddComponent(ComphiAPI::CreateComponent::Renderer(meshObjA, AlbedoA));
 
 	gameObjB = ComphiAPI::CreateObject::Entity();
-	auto& transformComponentB = gameObjB->AddComponent(ComphiAPI::CreateComponent::Transform());
+	auto transformComponentB = gameObjB->AddComponent(ComphiAPI::CreateComponent::Transform());
 	gameObjB->AddComponent(ComphiAPI::CreateComponent::Renderer(cubeVX, AlbedoB));
 
 	gameObjC = ComphiAPI::CreateObject::Entity();
-	auto& transformComponentC = gameObjC->AddComponent(ComphiAPI::CreateComponent::Transform());
+	auto transformComponentC = gameObjC->AddComponent(ComphiAPI::CreateComponent::Transform());
 	gameObjC->AddComponent(ComphiAPI::CreateComponent::Renderer(cubeVX, AlbedoA));
 	//diff mesh, same materal inst works (1 draw call per object)
 	// 
@@ -94,8 +101,8 @@ GameSceneLayer::GameSceneLayer() : Layer("GameSceneLayer") {
 	//same mesh, diff matInst fails in instanced rendering <<< WIP Mesh Instancing
 
 	CameraObj = ComphiAPI::CreateObject::Entity();
-	auto& cameraTransform = CameraObj->AddComponent(ComphiAPI::CreateComponent::Transform());
-	auto& cameraComponent = CameraObj->AddComponent(ComphiAPI::CreateComponent::Camera());
+	auto cameraTransform = CameraObj->AddComponent(ComphiAPI::CreateComponent::Transform());
+	auto cameraComponent = CameraObj->AddComponent(ComphiAPI::CreateComponent::Camera());
 	
 	scene = ComphiAPI::CreateObject::Scene();
 	scene->addEntity(CameraObj);
@@ -107,10 +114,16 @@ GameSceneLayer::GameSceneLayer() : Layer("GameSceneLayer") {
 
 void GameSceneLayer::OnStart()
 {
+#ifdef CPHI_RUN_BENCHMARKS
+	Comphi::Benchmarks::ComponentLookup();
+	Comphi::Benchmarks::TransformCompose();
+	Comphi::Benchmarks::PipelineCacheStartup(simpleMaterial);
+#endif
+
 	gameObjA->GetComponent<Transform>()->setEulerAngles(glm::vec3(-90, 45, 0));
-	gameObjA->GetComponent<Transform>()->scale = glm::vec3(3, 3, 3);
+	gameObjA->GetComponent<Transform>()->setScale(glm::vec3(3, 3, 3));
 
-	gameObjB->GetComponent<Transform>()->scale = glm::vec3(0.5f, 0.5f, 0.5f);
+	gameObjB->GetComponent<Transform>()->setScale(glm::vec3(0.5f, 0.5f, 0.5f));
 
 	//CameraObj->GetComponent<Transform>()->parent = gameObjA->GetComponent<Transform>();
 	//CameraObj->GetComponent<Transform>()->lookAt(glm::vec3(0.0f, 0.0f, 0.0f));
@@ -124,9 +137,9 @@ void GameSceneLayer::OnUpdate()
 {
 	time.Stop(); //TODO: send as parameter ?
 
-	CameraObj->GetComponent<Transform>()->position = glm::vec3(0.5f, 1.0f, -2 + glm::sin(time.sinceBegining()) / 2.0f);
+	CameraObj->GetComponent<Transform>()->setPosition(glm::vec3(0.5f, 1.0f, -2 + glm::sin(time.sinceBegining()) / 2.0f));
 
-	gameObjB->GetComponent<Transform>()->position = glm::vec3(glm::sin(time.sinceBegining()), 1 + glm::sin(time.sinceBegining()) / 2.0f, glm::cos(time.sinceBegining()));
+	gameObjB->GetComponent<Transform>()->setPosition(glm::vec3(glm::sin(time.sinceBegining()), 1 + glm::sin(time.sinceBegining()) / 2.0f, glm::cos(time.sinceBegining())));
 	gameObjB->GetComponent<Transform>()->eulerRotation(glm::vec3(glm::sin(time.sinceBegining())/3.0f, 1 + glm::sin(time.sinceBegining()) / 2.0f, glm::cos(time.sinceBegining())/2.0f ));
 	
 	gameObjA->GetComponent<Transform>()->eulerRotation(glm::vec3(0, 0, 10.0f * time.deltaTime()));